@@ -0,0 +1,37 @@
+#shader vertex
+#version 460 core
+
+// 覆盖全屏的三角形，顶点由gl_VertexID生成
+void main()
+{
+    vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+
+#shader fragment
+#version 460 core
+
+uniform sampler2D accumTexture;
+uniform sampler2D revealageTexture;
+uniform sampler2D nearestDepthTexture;
+uniform sampler2D sceneDepthTexture;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealageTexture, coord, 0).r;
+    // 没有透明片元覆盖
+    if (revealage >= 1.0)
+        discard;
+
+    vec4 accum = texelFetch(accumTexture, coord, 0);
+    // 权重累加溢出时退化为等权平均
+    if (isinf(max(max(abs(accum.r), abs(accum.g)), abs(accum.b))))
+        accum.rgb = vec3(accum.a);
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+    FragColor = vec4(average, 1.0 - revealage);
+    // 只有开启depthWrite的材质写过最近深度，其余像素保持场景深度
+    gl_FragDepth = min(texelFetch(nearestDepthTexture, coord, 0).r, texelFetch(sceneDepthTexture, coord, 0).r);
+}
\ No newline at end of file
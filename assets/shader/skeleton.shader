@@ -0,0 +1,45 @@
+#shader vertex
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// 量化顶点格式的位置解码，float格式时 scale = 1, offset = 0
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+// 逐实例数据，见Skeleton::Instance；前面是关节球，后面是连线圆锥
+struct SkeletonInstance
+{
+    mat4 model;
+    vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer SkeletonInstances
+{
+    SkeletonInstance instances[];
+};
+
+out vec4 instanceColor;
+
+void main()
+{
+    SkeletonInstance instance = instances[gl_BaseInstance + gl_InstanceID];
+    vec3 position = positionOffset + aPos * positionScale;
+    gl_Position = projection * view * model * instance.model * vec4(position, 1.0);
+    instanceColor = instance.color;
+}
+
+#shader fragment
+#version 460 core
+
+in vec4 instanceColor;
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = instanceColor;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#shader vertex
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// 逐绘制数据，见Renderer::DrawData；量化顶点格式的位置解码参数也在这里，float格式时 scale = 1, offset = 0
+struct DrawData
+{
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBuffer
+{
+    DrawData draws[];
+};
+
+void main()
+{
+    DrawData draw = draws[gl_BaseInstance + gl_InstanceID];
+    vec3 position = draw.positionOffset.xyz + aPos * draw.positionScale.xyz;
+    gl_Position = projection * view * draw.model * vec4(position, 1.0);
+}
+
+#shader fragment
+#version 460 core
+
+#ifdef OIT_PASS
+// 加权混合OIT的累积和透明度目标，见OitPass
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float revealage;
+layout (location = 2) out float nearestDepth;
+#else
+out vec4 FragColor;
+#endif
+
+// 材质参数，见Material
+layout (std140) uniform MaterialBlock
+{
+    vec4 color;
+};
+
+void main()
+{
+#ifdef OIT_PASS
+    // 离相机越近权重越大（McGuire & Bavoil的深度权重）
+    float weight = clamp(color.a * max(1e-2, 3e3 * pow(1.0 - gl_FragCoord.z, 3.0)), 1e-2, 3e3);
+    accum = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+    nearestDepth = gl_FragCoord.z;
+#else
+    FragColor = color;
+#endif
+}
\ No newline at end of file
@@ -7,19 +7,43 @@ layout (location = 3) in mat4 instanceModel;
 uniform mat4 view;
 uniform mat4 projection;
 
+// 量化顶点格式的位置解码，float格式时 scale = 1, offset = 0
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 void main()
 {
-    gl_Position = projection * view * instanceModel * vec4(aPos, 1.0);
+    vec3 position = positionOffset + aPos * positionScale;
+    gl_Position = projection * view * instanceModel * vec4(position, 1.0);
 }
 
 #shader fragment
 #version 330 core
 
+#ifdef OIT_PASS
+// 加权混合OIT的累积和透明度目标，见OitPass
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float revealage;
+layout (location = 2) out float nearestDepth;
+#else
 out vec4 FragColor;
+#endif
 
-uniform vec4 color;
+// 材质参数，见Material
+layout (std140) uniform MaterialBlock
+{
+    vec4 color;
+};
 
 void main()
 {
+#ifdef OIT_PASS
+    // 离相机越近权重越大（McGuire & Bavoil的深度权重）
+    float weight = clamp(color.a * max(1e-2, 3e3 * pow(1.0 - gl_FragCoord.z, 3.0)), 1e-2, 3e3);
+    accum = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+    nearestDepth = gl_FragCoord.z;
+#else
     FragColor = color;
+#endif
 }
\ No newline at end of file
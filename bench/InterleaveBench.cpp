@@ -0,0 +1,134 @@
+// Mesh顶点交错：新的InterleaveVertices/CopyFaceIndices 与原来逐顶点try/catch循环的对比
+// 用法: InterleaveBench [顶点数(百万) ...]，默认 1 2 5 10
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "VertexInterleave.h"
+
+// 与原来 Mesh::Mesh(aiMesh*, ...) 中的循环一致
+static void InterleaveLegacy(aiMesh *mesh, float *vertices, unsigned int *indices)
+{
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        try
+        {
+            vertices[i * 8 + 0] = mesh->mVertices[i].x;
+            vertices[i * 8 + 1] = mesh->mVertices[i].y;
+            vertices[i * 8 + 2] = mesh->mVertices[i].z;
+            vertices[i * 8 + 3] = mesh->mNormals[i].x;
+            vertices[i * 8 + 4] = mesh->mNormals[i].y;
+            vertices[i * 8 + 5] = mesh->mNormals[i].z;
+            if (mesh->mTextureCoords[0])
+            {
+                vertices[i * 8 + 6] = mesh->mTextureCoords[0][i].x;
+                vertices[i * 8 + 7] = mesh->mTextureCoords[0][i].y;
+            }
+            else
+            {
+                vertices[i * 8 + 6] = 0.0f;
+                vertices[i * 8 + 7] = 0.0f;
+            }
+        }
+        catch (...)
+        {
+            std::cout << "error happened when initialize vertices" << std::endl;
+        }
+    }
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    {
+        aiFace face = mesh->mFaces[i];
+        try
+        {
+            indices[i * 3 + 0] = face.mIndices[0];
+            indices[i * 3 + 1] = face.mIndices[1];
+            indices[i * 3 + 2] = face.mIndices[2];
+        }
+        catch (...)
+        {
+            std::cout << "error happened when initialize indices" << std::endl;
+        }
+    }
+}
+
+static std::unique_ptr<aiMesh> MakeMesh(unsigned int vertexCount)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    auto mesh = std::make_unique<aiMesh>();
+    mesh->mNumVertices = vertexCount;
+    mesh->mVertices = new aiVector3D[vertexCount];
+    mesh->mNormals = new aiVector3D[vertexCount];
+    mesh->mTextureCoords[0] = new aiVector3D[vertexCount];
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        mesh->mVertices[i] = aiVector3D(dist(rng), dist(rng), dist(rng));
+        mesh->mNormals[i] = aiVector3D(dist(rng), dist(rng), dist(rng));
+        mesh->mTextureCoords[0][i] = aiVector3D(dist(rng), dist(rng), 0.0f);
+    }
+
+    // 约两倍于顶点数的三角形
+    mesh->mNumFaces = vertexCount * 2;
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+    {
+        aiFace &face = mesh->mFaces[f];
+        face.mNumIndices = 3;
+        face.mIndices = new unsigned int[3]{(unsigned int)(rng() % vertexCount), (unsigned int)(rng() % vertexCount),
+                                            (unsigned int)(rng() % vertexCount)};
+    }
+    return mesh;
+}
+
+template <typename F>
+static double BestOf(int runs, F &&f)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<double> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::stod(argv[i]));
+    if (sizes.empty())
+        sizes = {1, 2, 5, 10};
+
+    for (double millions : sizes)
+    {
+        unsigned int vertexCount = (unsigned int)(millions * 1000000.0);
+        auto mesh = MakeMesh(vertexCount);
+
+        std::vector<float> legacyVertices(vertexCount * 8), vertices(vertexCount * 8);
+        std::vector<unsigned int> legacyIndices(mesh->mNumFaces * 3), indices(mesh->mNumFaces * 3);
+
+        double legacyTime = BestOf(3, [&]
+                                   { InterleaveLegacy(mesh.get(), legacyVertices.data(), legacyIndices.data()); });
+        double newTime = BestOf(3, [&]
+                                {
+                                    InterleaveVertices(mesh.get(), vertices.data());
+                                    CopyFaceIndices(mesh.get(), indices.data()); });
+
+        bool same = std::memcmp(legacyVertices.data(), vertices.data(), vertices.size() * sizeof(float)) == 0 &&
+                    std::memcmp(legacyIndices.data(), indices.data(), indices.size() * sizeof(unsigned int)) == 0;
+
+        std::cout << millions << "M vertices, " << mesh->mNumFaces << " faces\n"
+                  << "  legacy loop: " << legacyTime * 1000.0 << " ms\n"
+                  << "  interleave:  " << newTime * 1000.0 << " ms\n"
+                  << "  speedup:     " << legacyTime / newTime << "x" << (same ? "" : "  (OUTPUT MISMATCH)") << std::endl;
+    }
+    return 0;
+}
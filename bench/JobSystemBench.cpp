@@ -0,0 +1,127 @@
+// JobSystem 从1到N个线程的扩展性测试
+// 用法: JobSystemBench [最大线程数]，默认 hardware_concurrency
+// 每种线程数都是 Start(线程数 - 1) 后主线程和工作线程一起执行，加速比相对于1个线程（包含调度开销）
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "FrustumCull.h"
+#include "Transform.h"
+
+template <typename F>
+static double BestOf(int runs, F &&f)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+struct Workload
+{
+    std::string name;
+    std::function<void()> run;
+};
+
+int main(int argc, char **argv)
+{
+    unsigned int maxThreads = argc > 1 ? (unsigned int)std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+    // 计算密集：逐元素的超越函数
+    const size_t computeCount = 1 << 24;
+    std::vector<float> computeOut(computeCount);
+
+    // 访存密集：100万个包围盒的视锥剔除
+    const size_t boxCount = 1 << 20;
+    std::vector<float> boxes(boxCount * 6);
+    for (float &value : boxes)
+        value = dist(rng);
+    for (size_t i = boxCount * 3; i < boxCount * 6; i++)
+        boxes[i] = std::fabs(boxes[i]) * 0.05f;
+    std::vector<uint8_t> visible(boxCount);
+    Frustum frustum = Frustum::FromMatrix(glm::mat4(0.2f, 0.0f, 0.0f, 0.0f, 0.0f, 0.2f, 0.0f, 0.0f,
+                                                    0.0f, 0.0f, -0.2f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+
+    // 任务图：大量很小的任务，测调度开销
+    const size_t tinyJobCount = 100000;
+    std::atomic<size_t> tinyCounter = 0;
+
+    // transform：10万个对象全部修改后批量重算
+    const size_t transformCount = 100000;
+    std::vector<std::unique_ptr<Transform>> transforms;
+    for (size_t i = 0; i < transformCount; i++)
+        transforms.push_back(std::make_unique<Transform>());
+
+    std::vector<Workload> workloads = {
+        {"compute (16M sin/sqrt)", [&]
+         {
+             JobSystem::Instance().ParallelFor(0, computeCount, 1 << 14, [&](size_t begin, size_t end)
+                                               {
+                                                   for (size_t i = begin; i < end; i++)
+                                                       computeOut[i] = std::sqrt(std::sin((float)i) * std::sin((float)i) + 1.0f); });
+         }},
+        {"frustum cull (1M boxes)", [&]
+         {
+             const float *data = boxes.data();
+             JobSystem::Instance().ParallelFor(0, boxCount, 1 << 14, [&](size_t begin, size_t end)
+                                               { CullBoxes(frustum, data + begin, data + boxCount + begin, data + boxCount * 2 + begin,
+                                                           data + boxCount * 3 + begin, data + boxCount * 4 + begin,
+                                                           data + boxCount * 5 + begin, end - begin, visible.data() + begin); });
+         }},
+        {"tiny jobs (100k)", [&]
+         {
+             tinyCounter = 0;
+             JobSystem &jobSystem = JobSystem::Instance();
+             JobHandle root = jobSystem.Create([] {});
+             for (size_t i = 0; i < tinyJobCount; i++)
+             {
+                 jobSystem.Schedule([&tinyCounter]
+                                    { tinyCounter.fetch_add(1, std::memory_order_relaxed); },
+                                    root);
+             }
+             jobSystem.Run(root);
+             jobSystem.Wait(root);
+         }},
+        {"transforms (100k dirty)", [&]
+         {
+             for (size_t i = 0; i < transformCount; i++)
+                 transforms[i]->position(Vector3((float)i, 0.0f, 0.0f));
+             TransformStore::Instance().UpdateDirty();
+         }},
+    };
+
+    std::vector<double> baseline(workloads.size());
+    for (unsigned int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem::Instance().Start((int)threads - 1);
+        std::cout << threads << " thread(s)" << std::endl;
+        for (size_t w = 0; w < workloads.size(); w++)
+        {
+            double seconds = BestOf(5, workloads[w].run);
+            if (threads == 1)
+                baseline[w] = seconds;
+            std::cout << "  " << std::left << std::setw(26) << workloads[w].name << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(9) << seconds * 1000.0 << " ms   speedup "
+                      << std::setprecision(2) << baseline[w] / seconds << "x" << std::endl;
+        }
+        JobSystem::Instance().Shutdown();
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// RigParser 与旧的 std::regex 解析路径的吞吐量对比
+// 用法: RigParserBench [rig.txt ...]，不给参数时生成一个合成的稠密rig文件
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RigParser.h"
+
+namespace fs = std::filesystem;
+
+// 与原来 SkeletonViewerApp::AddDroppedFileToScene 中的实现一致
+static size_t ParseRegexLegacy(const std::string &path)
+{
+    std::ifstream file(path);
+    std::unordered_map<std::string, glm::vec3> jointPositions;
+    std::unordered_map<std::string, std::string> parentOf;
+    std::unordered_map<std::string, std::vector<std::string>> childrenOf;
+
+    std::regex jointRegex(R"(j\s+<(.+)>\s+(.+)\s+(.+)\s+(.+))");
+    std::regex edgeRegex(R"(e\s+<(.+)>\s+<(.+)>)");
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+        if (line[0] == 'j')
+        {
+            std::smatch match;
+            if (std::regex_match(line, match, jointRegex))
+            {
+                jointPositions[match[1]] = {std::stof(match[2]), std::stof(match[3]), std::stof(match[4])};
+            }
+        }
+        else if (line[0] == 'e')
+        {
+            std::smatch match;
+            if (std::regex_match(line, match, edgeRegex))
+            {
+                parentOf[match[2]] = match[1];
+                childrenOf[match[1]].push_back(match[2]);
+            }
+        }
+    }
+    return jointPositions.size();
+}
+
+static void WriteSyntheticRig(const std::string &path, int jointCount)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::ofstream out(path);
+    for (int i = 0; i < jointCount; i++)
+        out << "j <joint_" << i << "> " << dist(rng) << " " << dist(rng) << " " << dist(rng) << "\n";
+    for (int i = 1; i < jointCount; i++)
+        out << "e <joint_" << (i - 1) / 3 << "> <joint_" << i << ">\n";
+}
+
+template <typename F>
+static double BestOf(int runs, F &&f)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++)
+        files.push_back(argv[i]);
+
+    std::string synthetic;
+    if (files.empty())
+    {
+        synthetic = (fs::temp_directory_path() / "rig_bench_synthetic.txt").string();
+        WriteSyntheticRig(synthetic, 200000);
+        files.push_back(synthetic);
+    }
+
+    for (auto &path : files)
+    {
+        double mb = (double)fs::file_size(path) / (1024.0 * 1024.0);
+
+        size_t regexJoints = 0;
+        double regexTime = BestOf(3, [&]
+                                  { regexJoints = ParseRegexLegacy(path); });
+
+        RigData rig;
+        double parserTime = BestOf(5, [&]
+                                   { RigParser::ParseFile(path, rig); });
+
+        std::cout << path << " (" << mb << " MB)\n"
+                  << "  regex:     " << regexTime * 1000.0 << " ms, " << mb / regexTime << " MB/s, " << regexJoints << " joints\n"
+                  << "  RigParser: " << parserTime * 1000.0 << " ms, " << mb / parserTime << " MB/s, " << rig.JointCount() << " joints\n"
+                  << "  speedup:   " << regexTime / parserTime << "x" << std::endl;
+    }
+
+    if (!synthetic.empty())
+        fs::remove(synthetic);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// 渲染排序键：RadixSortByKey 与 std::stable_sort 的对比，结果必须一致
+// 用法: SortKeyBench [键数(千) ...]，默认 10 50 200 1000
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RadixSort.h"
+
+// 与Renderer::SortItem一致
+struct SortItem
+{
+    uint64_t key;
+    unsigned int packet;
+};
+
+template <typename F>
+static double BestOf(int runs, F &&f)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+// 按Renderer::MakeSortKey的不透明布局生成键：queue | shader | material | mesh | lod | 深度
+static std::vector<SortItem> MakeItems(size_t count)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<unsigned int> shader(1, 8);
+    std::uniform_int_distribution<unsigned int> material(1, 200);
+    std::uniform_int_distribution<unsigned int> mesh(1, 4000);
+    std::uniform_int_distribution<int> lod(0, 3);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+    std::vector<SortItem> items(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        float viewDepth = depth(rng);
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+        uint64_t key = (uint64_t)2000 << 52;
+        key |= (uint64_t)(shader(rng) & 0x3FF) << 42;
+        key |= (uint64_t)(material(rng) & 0xFFF) << 30;
+        key |= (uint64_t)(mesh(rng) & 0xFFFF) << 14;
+        key |= (uint64_t)(lod(rng) & 0x7) << 11;
+        key |= (uint64_t)(depthBits >> 21);
+        items[i] = {key, (unsigned int)i};
+    }
+    return items;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++)
+        counts.push_back((size_t)(std::stod(argv[i]) * 1000));
+    if (counts.empty())
+        counts = {10000, 50000, 200000, 1000000};
+
+    for (size_t count : counts)
+    {
+        std::vector<SortItem> source = MakeItems(count);
+        std::vector<SortItem> items(count), scratch(count), reference;
+        SortItem *result = nullptr;
+
+        double radixSeconds = BestOf(5, [&]
+                                     {
+                                         items = source;
+                                         result = RadixSortByKey(items.data(), scratch.data(), count); });
+        double stableSeconds = BestOf(5, [&]
+                                      {
+                                          reference = source;
+                                          std::stable_sort(reference.begin(), reference.end(), [](const SortItem &a, const SortItem &b)
+                                                           { return a.key < b.key; }); });
+
+        bool match = std::equal(reference.begin(), reference.end(), result, [](const SortItem &a, const SortItem &b)
+                                { return a.key == b.key && a.packet == b.packet; });
+        std::cout << std::setw(8) << count << " keys   radix " << std::fixed << std::setprecision(3)
+                  << radixSeconds * 1000.0 << " ms   stable_sort " << stableSeconds * 1000.0 << " ms   "
+                  << (match ? "match" : "MISMATCH") << std::endl;
+        if (!match)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "AllocationCounter.h"
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static thread_local size_t threadAllocations = 0;
+static std::atomic<size_t> trackedAllocations{0};
+
+size_t AllocationCounter::ThreadCount()
+{
+    return threadAllocations;
+}
+
+size_t AllocationCounter::TrackedCount()
+{
+    return trackedAllocations.load(std::memory_order_relaxed);
+}
+
+static void Count()
+{
+    threadAllocations++;
+    if (AllocationCounter::trackingDepth > 0)
+        trackedAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void *CountedAlloc(size_t size)
+{
+    Count();
+    return std::malloc(size ? size : 1);
+}
+
+static void *CountedAlignedAlloc(size_t size, std::align_val_t alignment)
+{
+    Count();
+    size_t align = (size_t)alignment;
+    size = (size + align - 1) / align * align;
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : align, align);
+#else
+    return std::aligned_alloc(align, size ? size : align);
+#endif
+}
+
+static void AlignedFree(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void *operator new(size_t size)
+{
+    if (void *ptr = CountedAlloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *ptr = CountedAlignedAlloc(size, alignment))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { AlignedFree(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { AlignedFree(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { AlignedFree(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { AlignedFree(ptr); }
+
+#else
+size_t AllocationCounter::ThreadCount()
+{
+    return 0;
+}
+
+size_t AllocationCounter::TrackedCount()
+{
+    return 0;
+}
+#endif
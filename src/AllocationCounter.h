@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+// 替换全局operator new/delete统计堆分配次数，用于检查渲染帧是否还有堆分配
+// 只在CMake选项ENABLE_ALLOCATION_TRACKING打开时替换，否则计数始终为0
+// 除按线程计数外，处于TrackScope中的线程的分配还计入一个全局计数；
+// JobSystem把创建任务时的跟踪状态带到执行任务的线程上，渲染路径中并行执行的部分也能统计到
+namespace AllocationCounter
+{
+#ifdef ENABLE_ALLOCATION_TRACKING
+    inline constexpr bool ENABLED = true;
+#else
+    inline constexpr bool ENABLED = false;
+#endif
+
+    // 当前线程累计的operator new次数
+    size_t ThreadCount();
+    // 所有线程在跟踪范围内累计的operator new次数
+    size_t TrackedCount();
+
+    // 大于0时本线程的分配计入TrackedCount；定义在头文件中，JobSystem使用时不需要链接计数器
+    inline thread_local int trackingDepth = 0;
+
+    struct TrackScope
+    {
+        TrackScope() { trackingDepth++; }
+        ~TrackScope() { trackingDepth--; }
+        TrackScope(const TrackScope &) = delete;
+        TrackScope &operator=(const TrackScope &) = delete;
+    };
+}
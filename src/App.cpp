@@ -8,9 +8,16 @@
 #include "Scene.h"
 #include "Camera.h"
 #include "Renderer.h"
+#include "TransformStore.h"
+#include "AllocationCounter.h"
+#include "GLState.h"
+#include "GeometryArena.h"
 #include "GlobalTime.h"
 #include "MeshManager.h"
 #include "SceneManager.h"
+#include "ImportService.h"
+#include "JobSystem.h"
+#include "PrimitiveRegistry.h"
 #include "EventDispatcher.h"
 
 App::App(int width, int height, const std::string &title)
@@ -31,6 +38,9 @@ bool App::Init()
     if (!InitImGui())
         return false;
 
+    // 主线程作为0号线程参与任务执行，必须在主线程启动
+    JobSystem::Instance().Start();
+
     // 初始化场景与摄像机
     SceneManager::SetCurrentScene(std::make_shared<Scene>());
     auto camera = std::dynamic_pointer_cast<Camera>(SceneObject::create("Camera", "main camera"));
@@ -51,7 +61,12 @@ bool App::Init()
 
 void App::Destroy()
 {
+    ImportService::Instance().Shutdown();
+    JobSystem::Instance().Shutdown();
+    PrimitiveRegistry::Instance().Clear();
     MeshManager::Instance().Clear();
+    Renderer::Instance().Release();
+    GeometryArena::Instance().Release();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -133,6 +148,8 @@ void App::Run()
         float deltaTime = GlobalTime::GetFrameDeltaTime();
 
         ProcessEvents();
+        // 工作线程提交的主线程任务（GL调用等）
+        JobSystem::Instance().RunMainThreadJobs();
         Update();
 
         RenderBefore();
@@ -160,17 +177,21 @@ void App::ProcessEvents()
 void App::Update()
 {
     SceneManager::Update();
+    // 对象的update()修改过的transform在这里统一重算，绘制时读到的都是最新矩阵
+    TransformStore::Instance().UpdateDirty();
 }
 
 void App::RenderClear()
 {
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_TRUE);
+    GLState &state = GLState::Instance();
+    state.ResetCounters();
+    state.SetDepthTest(true);
+    state.SetDepthFunc(GL_LEQUAL);
+    state.SetDepthWrite(true);
     glClearDepth(1.0f);
 
-    glDisable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
+    state.SetBlend(false);
+    state.SetCullFace(false);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     auto backgroundColor = SceneManager::GetMainCamera()->backgroundColor;
@@ -182,17 +203,32 @@ void App::RenderBefore() {}
 
 void App::Render()
 {
-    SceneManager::GetCurrentScene()->lightManager.UploadToGPU();
-    SceneManager::GetCurrentScene()->lightManager.BindToShader(0); // UBO binding point 0
+    // 统计渲染路径（提交、排序、绘制）上的堆分配，包括其中并行执行的任务，稳态下应为0
+    size_t allocationsBefore = AllocationCounter::TrackedCount();
+    {
+        AllocationCounter::TrackScope trackScope;
 
-    SceneManager::Draw(); // 提交绘制
+        SceneManager::GetCurrentScene()->lightManager.UploadToGPU();
+        SceneManager::GetCurrentScene()->lightManager.BindToShader(LIGHT_BINDING);
 
-    auto camera = SceneManager::GetMainCamera();
+        SceneManager::Draw(); // 提交绘制
 
-    Renderer::Instance().FlushBatches(
-        camera->GetViewMatrix(),
-        camera->GetProjectionMatrix((float)width / (float)height));
-    MeshManager::Instance().CleanupUnusedMeshes();
+        auto camera = SceneManager::GetMainCamera();
+
+        Renderer::Instance().FlushBatches(
+            camera->GetViewMatrix(),
+            camera->GetProjectionMatrix((float)width / (float)height));
+        MeshManager::Instance().CleanupUnusedMeshes();
+    }
+
+    // 场景对象增删后容器会继续增长，重新预热
+    size_t objectCount = SceneManager::GetCurrentScene()->ObjectCount();
+    if (objectCount != lastObjectCount)
+    {
+        lastObjectCount = objectCount;
+        Renderer::Instance().RestartAllocationWarmup();
+    }
+    Renderer::Instance().ReportFrameAllocations(AllocationCounter::TrackedCount() - allocationsBefore);
 }
 
 void App::RenderAfter() {}
@@ -211,6 +247,8 @@ void App::RenderImGuiAfter()
     ImGui::End();
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // ImGui直接修改了GL状态
+    GLState::Instance().Invalidate();
 }
 
 void App::KeyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
@@ -51,6 +51,9 @@ protected:
     bool running = false;
 
 private:
+    size_t lastObjectCount = 0; // 场景对象数变化时重新开始分配检查的预热
+
+
     static void KeyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
     static void MouseButtonCallback(GLFWwindow *window, int button, int action, int mods);
     static void CursorPosCallback(GLFWwindow *window, double xpos, double ypos);
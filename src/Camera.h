@@ -12,6 +12,8 @@ class Camera : public SceneObject
 {
 public:
 	REGISTER_SCENE_OBJECT(Camera)
+	// 读取窗口输入，只在主线程更新
+	REGISTER_SCENE_SYSTEM(Camera, 0, RESOURCE_INPUT, RESOURCE_TRANSFORMS, JobAffinity::MainThread, 0)
 
 	glm::vec3 backgroundColor = Color(255, 255, 255);
 
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+// 每帧线性分配器：Allocate只移动偏移，Reset时整体回收
+// 本帧容量不够时临时从堆上分配溢出块，下一次Reset按峰值一次性扩容，稳态下不再有堆分配
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialBytes = 64 * 1024)
+        : buffer(new unsigned char[initialBytes]), capacity(initialBytes) {}
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // 只用于平凡析构的类型，Reset时不会调用析构函数
+    template <typename T>
+    T *Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena only holds trivially destructible types");
+        size_t bytes = count * sizeof(T);
+        size_t aligned = (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+        if (aligned + bytes <= capacity)
+        {
+            offset = aligned + bytes;
+            peak = std::max(peak, offset);
+            return reinterpret_cast<T *>(buffer.get() + aligned);
+        }
+
+        // 溢出：记录需求，本帧先用单独的堆块
+        peak = std::max(peak, aligned + bytes + overflowBytes);
+        overflowBytes += bytes;
+        overflow.emplace_back(new unsigned char[bytes + alignof(T)]);
+        unsigned char *raw = overflow.back().get();
+        size_t misalign = reinterpret_cast<size_t>(raw) % alignof(T);
+        return reinterpret_cast<T *>(raw + (misalign ? alignof(T) - misalign : 0));
+    }
+
+    void Reset()
+    {
+        if (!overflow.empty())
+        {
+            overflow.clear();
+            capacity = peak + peak / 2;
+            buffer.reset(new unsigned char[capacity]);
+        }
+        offset = 0;
+        overflowBytes = 0;
+    }
+
+    size_t Capacity() const { return capacity; }
+    size_t Used() const { return offset + overflowBytes; }
+
+private:
+    std::unique_ptr<unsigned char[]> buffer;
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t peak = 0;
+    size_t overflowBytes = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+};
@@ -0,0 +1,91 @@
+#include "FrustumCull.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4 &matrix)
+{
+    glm::vec4 row0(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+    glm::vec4 row1(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+    glm::vec4 row2(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+    glm::vec4 row3(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+
+    Frustum frustum{{row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2}};
+    for (auto &plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane /= length;
+    }
+    return frustum;
+}
+
+size_t CullBoxes(const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ,
+                 const float *extentX, const float *extentY, const float *extentZ, size_t count, uint8_t *visible)
+{
+    // 包围盒在平面外侧的条件：dot(n, c) + w < -(|n.x| * e.x + |n.y| * e.y + |n.z| * e.z)
+    size_t visibleCount = 0;
+    size_t i = 0;
+#ifdef FRUSTUM_SSE
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(centerX + i);
+        __m128 cy = _mm_loadu_ps(centerY + i);
+        __m128 cz = _mm_loadu_ps(centerZ + i);
+        __m128 ex = _mm_loadu_ps(extentX + i);
+        __m128 ey = _mm_loadu_ps(extentY + i);
+        __m128 ez = _mm_loadu_ps(extentZ + i);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+                                       _mm_mul_ps(absZ[p], ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; k++)
+        {
+            visible[i + k] = (mask >> k) & 1;
+            visibleCount += (mask >> k) & 1;
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        bool inside = true;
+        for (const auto &plane : frustum.planes)
+        {
+            float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+            float radius = std::fabs(plane.x) * extentX[i] + std::fabs(plane.y) * extentY[i] +
+                           std::fabs(plane.z) * extentZ[i];
+            if (distance + radius < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+        visible[i] = inside ? 1 : 0;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// 视锥的6个平面（已归一化，法线指向视锥内部），dot(n, p) + w < 0 表示在平面外侧
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Gribb-Hartmann：从变换矩阵的行提取平面，平面所在空间即矩阵的输入空间
+    static Frustum FromMatrix(const glm::mat4 &matrix);
+};
+
+// 按SoA存放的count个AABB（中心 + 半长）做视锥测试，visible[i]写入0/1，返回可见个数
+// 支持SSE时每次迭代处理4个包围盒
+size_t CullBoxes(const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ,
+                 const float *extentX, const float *extentY, const float *extentZ, size_t count, uint8_t *visible);
@@ -0,0 +1,229 @@
+#include "GLState.h"
+
+int GLState::BufferTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:
+        return 0;
+    case GL_UNIFORM_BUFFER:
+        return 1;
+    case GL_SHADER_STORAGE_BUFFER:
+        return 2;
+    case GL_DRAW_INDIRECT_BUFFER:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+int GLState::IndexedTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_UNIFORM_BUFFER:
+        return 0;
+    case GL_SHADER_STORAGE_BUFFER:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+void GLState::UseProgram(GLuint value)
+{
+    if (Changed(program, value))
+        glUseProgram(value);
+}
+
+void GLState::BindVertexArray(GLuint value)
+{
+    if (Changed(vao, value))
+        glBindVertexArray(value);
+}
+
+void GLState::BindTexture(unsigned int unit, GLuint texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        counters.issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        activeUnit = unit;
+        return;
+    }
+    if (textures[unit] == texture)
+    {
+        counters.filtered++;
+        return;
+    }
+    if (Changed(activeUnit, (GLuint)unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    Changed(textures[unit], texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    int index = BufferTargetIndex(target);
+    if (index < 0)
+    {
+        counters.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (Changed(buffers[index], buffer))
+        glBindBuffer(target, buffer);
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    int slot = IndexedTargetIndex(target);
+    if (slot < 0 || index >= MAX_BUFFER_BINDINGS)
+    {
+        counters.issued++;
+        glBindBufferBase(target, index, buffer);
+        return;
+    }
+    if (Changed(indexedBuffers[slot][index], IndexedBinding{buffer, 0, 0}))
+    {
+        glBindBufferBase(target, index, buffer);
+        buffers[BufferTargetIndex(target)] = buffer;
+    }
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    int slot = IndexedTargetIndex(target);
+    if (slot < 0 || index >= MAX_BUFFER_BINDINGS)
+    {
+        counters.issued++;
+        glBindBufferRange(target, index, buffer, offset, size);
+        return;
+    }
+    if (Changed(indexedBuffers[slot][index], IndexedBinding{buffer, offset, size}))
+    {
+        glBindBufferRange(target, index, buffer, offset, size);
+        buffers[BufferTargetIndex(target)] = buffer;
+    }
+}
+
+static void SetCapability(GLenum capability, bool enable)
+{
+    if (enable)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::SetDepthTest(bool enable)
+{
+    if (Changed(depthTest, (int)enable))
+        SetCapability(GL_DEPTH_TEST, enable);
+}
+
+void GLState::SetDepthWrite(bool enable)
+{
+    if (Changed(depthWrite, (int)enable))
+        glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::SetDepthFunc(GLenum func)
+{
+    if (Changed(depthFunc, func))
+        glDepthFunc(func);
+}
+
+void GLState::SetBlend(bool enable)
+{
+    if (Changed(blend, (int)enable))
+        SetCapability(GL_BLEND, enable);
+}
+
+void GLState::SetBlendFunc(GLenum src, GLenum dst)
+{
+    if (blendSrc == src && blendDst == dst)
+    {
+        counters.filtered++;
+        return;
+    }
+    blendSrc = src;
+    blendDst = dst;
+    counters.issued++;
+    glBlendFunc(src, dst);
+}
+
+void GLState::SetBlendFunci(GLuint buffer, GLenum src, GLenum dst)
+{
+    blendSrc = UNKNOWN;
+    blendDst = UNKNOWN;
+    counters.issued++;
+    glBlendFunci(buffer, src, dst);
+}
+
+void GLState::SetCullFace(bool enable)
+{
+    if (Changed(cullFace, (int)enable))
+        SetCapability(GL_CULL_FACE, enable);
+}
+
+void GLState::ForgetProgram(GLuint value)
+{
+    if (program == value)
+        program = 0;
+}
+
+void GLState::ForgetVertexArray(GLuint value)
+{
+    if (vao == value)
+        vao = 0;
+}
+
+void GLState::ForgetTexture(GLuint texture)
+{
+    for (GLuint &bound : textures)
+    {
+        if (bound == texture)
+            bound = 0;
+    }
+}
+
+void GLState::ForgetBuffer(GLuint buffer)
+{
+    for (GLuint &bound : buffers)
+    {
+        if (bound == buffer)
+            bound = 0;
+    }
+    for (auto &slots : indexedBuffers)
+    {
+        for (auto &binding : slots)
+        {
+            if (binding.buffer == buffer)
+                binding = IndexedBinding{0, 0, 0};
+        }
+    }
+}
+
+void GLState::Invalidate()
+{
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (GLuint &texture : textures)
+        texture = UNKNOWN;
+    for (GLuint &buffer : buffers)
+        buffer = UNKNOWN;
+    for (auto &slots : indexedBuffers)
+    {
+        for (auto &binding : slots)
+            binding = IndexedBinding{UNKNOWN, 0, 0};
+    }
+    depthTest = -1;
+    depthWrite = -1;
+    depthFunc = UNKNOWN;
+    blend = -1;
+    blendSrc = UNKNOWN;
+    blendDst = UNKNOWN;
+    cullFace = -1;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+
+// GL状态缓存：记录当前绑定的program/VAO/纹理/缓冲区和深度/混合/剔除状态，只有真正变化时才调用GL
+// 所有渲染代码都应通过这里修改这些状态；外部代码（如ImGui）直接改过GL状态后必须调用Invalidate()
+// 删除GL对象前调用对应的Forget*()，否则id被复用时会被误判为已绑定
+class GLState
+{
+public:
+    static constexpr int MAX_TEXTURE_UNITS = 32;
+    static constexpr int MAX_BUFFER_BINDINGS = 16;
+
+    struct Counters
+    {
+        size_t issued = 0;   // 实际调用GL的次数
+        size_t filtered = 0; // 因状态未变而跳过的次数
+    };
+
+    static GLState &Instance()
+    {
+        static GLState instance;
+        return instance;
+    }
+    GLState(const GLState &) = delete;
+    GLState &operator=(const GLState &) = delete;
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    // 只缓存GL_TEXTURE_2D
+    void BindTexture(unsigned int unit, GLuint texture);
+    // GL_ELEMENT_ARRAY_BUFFER属于VAO状态，不缓存，直接透传
+    void BindBuffer(GLenum target, GLuint buffer);
+    // GL_UNIFORM_BUFFER/GL_SHADER_STORAGE_BUFFER的索引绑定点，同时会改变target的通用绑定
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    void SetDepthTest(bool enable);
+    void SetDepthWrite(bool enable);
+    void SetDepthFunc(GLenum func);
+    void SetBlend(bool enable);
+    void SetBlendFunc(GLenum src, GLenum dst);
+    // 单个draw buffer的混合函数，不缓存；调用后全局混合函数的缓存变为未知
+    void SetBlendFunci(GLuint buffer, GLenum src, GLenum dst);
+    void SetCullFace(bool enable);
+
+    void ForgetProgram(GLuint program);
+    void ForgetVertexArray(GLuint vao);
+    void ForgetTexture(GLuint texture);
+    void ForgetBuffer(GLuint buffer);
+
+    // 把所有缓存标记为未知，下一次设置一定会调用GL
+    void Invalidate();
+
+    const Counters &GetCounters() const { return counters; }
+    void ResetCounters() { counters = Counters(); }
+
+private:
+    GLState() { Invalidate(); }
+
+    // 返回true表示需要调用GL，并更新缓存
+    template <typename T>
+    bool Changed(T &cached, T value)
+    {
+        if (cached == value)
+        {
+            counters.filtered++;
+            return false;
+        }
+        cached = value;
+        counters.issued++;
+        return true;
+    }
+
+    // 缓存的通用绑定点下标，-1表示不缓存
+    static int BufferTargetIndex(GLenum target);
+    static int IndexedTargetIndex(GLenum target);
+
+    struct IndexedBinding
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size; // 0表示整个缓冲区（BindBufferBase）
+        bool operator==(const IndexedBinding &other) const
+        {
+            return buffer == other.buffer && offset == other.offset && size == other.size;
+        }
+    };
+
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    GLuint program;
+    GLuint vao;
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS];
+    GLuint buffers[4];
+    IndexedBinding indexedBuffers[2][MAX_BUFFER_BINDINGS];
+    // 布尔状态用int保存，-1表示未知
+    int depthTest;
+    int depthWrite;
+    GLenum depthFunc;
+    int blend;
+    GLenum blendSrc;
+    GLenum blendDst;
+    int cullFace;
+
+    Counters counters;
+};
@@ -0,0 +1,191 @@
+#include "GeometryArena.h"
+#include "GLState.h"
+#include "Mesh.h"
+#include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+bool GeometryPage::FreeList::Allocate(size_t count, size_t &offset)
+{
+    for (auto it = blocks.begin(); it != blocks.end(); ++it)
+    {
+        if (it->second < count)
+            continue;
+        offset = it->first;
+        size_t remaining = it->second - count;
+        blocks.erase(it);
+        if (remaining > 0)
+            blocks[offset + count] = remaining;
+        return true;
+    }
+    return false;
+}
+
+void GeometryPage::FreeList::Free(size_t offset, size_t count)
+{
+    if (count == 0)
+        return;
+    auto next = blocks.lower_bound(offset);
+    // 与后一个空闲区间相邻时合并
+    if (next != blocks.end() && offset + count == next->first)
+    {
+        count += next->second;
+        next = blocks.erase(next);
+    }
+    // 与前一个空闲区间相邻时合并
+    if (next != blocks.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            prev->second += count;
+            return;
+        }
+    }
+    blocks[offset] = count;
+}
+
+GeometryPage::GeometryPage(VertexFormat format, int indexSize, size_t vertexCapacity, size_t indexCapacity)
+    : format(format), indexSize(indexSize), vertexCapacity(vertexCapacity), indexCapacity(indexCapacity)
+{
+    freeVertices.blocks[0] = vertexCapacity;
+    freeIndices.blocks[0] = indexCapacity;
+
+    int stride = VertexStride(format);
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, vertexCapacity * stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &ibo);
+    glNamedBufferStorage(ibo, indexCapacity * indexSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    GLState &state = GLState::Instance();
+    glGenVertexArrays(1, &vao);
+    state.BindVertexArray(vao);
+    // 元素缓冲绑定属于VAO状态
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBindVertexBuffer(0, vbo, 0, stride);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    if (format == VertexFormat::Packed16)
+    {
+        // 归一化整数由顶点拉取阶段转成[0,1]/[-1,1]的float，位置在着色器中按包围盒还原
+        glVertexAttribFormat(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedVertex, position));
+        glVertexAttribFormat(1, 2, GL_SHORT, GL_TRUE, offsetof(PackedVertex, normal));
+        glVertexAttribFormat(2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, uv));
+    }
+    else
+    {
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0 * sizeof(float));
+        glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+        glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        glVertexAttribBinding(i, 0);
+    }
+
+    // 实例矩阵占4个属性位置，数据来自绑定点INSTANCE_BINDING，绘制时再绑定具体的缓冲区
+    for (int i = 0; i < 4; i++)
+    {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribFormat(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * i);
+        glVertexAttribBinding(3 + i, Mesh::INSTANCE_BINDING);
+    }
+    glVertexBindingDivisor(Mesh::INSTANCE_BINDING, 1);
+}
+
+GeometryPage::~GeometryPage()
+{
+    GLState &state = GLState::Instance();
+    state.ForgetVertexArray(vao);
+    glDeleteVertexArrays(1, &vao);
+    state.ForgetBuffer(vbo);
+    glDeleteBuffers(1, &vbo);
+    state.ForgetBuffer(ibo);
+    glDeleteBuffers(1, &ibo);
+}
+
+bool GeometryPage::Allocate(size_t vertexCount, size_t indexCount, size_t &baseVertex, size_t &firstIndex)
+{
+    if (!freeVertices.Allocate(vertexCount, baseVertex))
+        return false;
+    if (!freeIndices.Allocate(indexCount, firstIndex))
+    {
+        freeVertices.Free(baseVertex, vertexCount);
+        return false;
+    }
+    allocationCount++;
+    return true;
+}
+
+void GeometryPage::Free(size_t baseVertex, size_t vertexCount, size_t firstIndex, size_t indexCount)
+{
+    freeVertices.Free(baseVertex, vertexCount);
+    freeIndices.Free(firstIndex, indexCount);
+    allocationCount--;
+}
+
+void GeometryPage::UploadVertices(size_t baseVertex, const void *data, size_t vertexCount)
+{
+    size_t stride = VertexStride(format);
+    glNamedBufferSubData(vbo, baseVertex * stride, vertexCount * stride, data);
+}
+
+void GeometryPage::UploadIndices(size_t firstIndex, const void *data, size_t indexCount)
+{
+    glNamedBufferSubData(ibo, firstIndex * indexSize, indexCount * indexSize, data);
+}
+
+GeometryAllocation GeometryArena::Allocate(VertexFormat format, int indexSize, size_t vertexCount, size_t indexCount)
+{
+    GeometryAllocation allocation;
+    allocation.vertexCount = (unsigned int)vertexCount;
+    allocation.indexCount = (unsigned int)indexCount;
+
+    size_t baseVertex = 0, firstIndex = 0;
+    for (auto &page : pages)
+    {
+        if (page->format != format || page->indexSize != indexSize)
+            continue;
+        if (page->Allocate(vertexCount, indexCount, baseVertex, firstIndex))
+        {
+            allocation.page = page;
+            allocation.baseVertex = (unsigned int)baseVertex;
+            allocation.firstIndex = (unsigned int)firstIndex;
+            return allocation;
+        }
+    }
+
+    size_t vertexCapacity = std::max(PAGE_VERTEX_BYTES / VertexStride(format), vertexCount);
+    size_t indexCapacity = std::max(PAGE_INDEX_BYTES / indexSize, indexCount);
+    auto page = std::make_shared<GeometryPage>(format, indexSize, vertexCapacity, indexCapacity);
+    pages.push_back(page);
+    std::cout << "[GeometryArena] new page #" << pages.size() << ": " << vertexCapacity << " vertices, "
+              << indexCapacity << " indices (uint" << indexSize * 8 << ")" << std::endl;
+
+    page->Allocate(vertexCount, indexCount, baseVertex, firstIndex);
+    allocation.page = page;
+    allocation.baseVertex = (unsigned int)baseVertex;
+    allocation.firstIndex = (unsigned int)firstIndex;
+    return allocation;
+}
+
+void GeometryArena::Free(GeometryAllocation &allocation)
+{
+    if (!allocation.page)
+        return;
+    allocation.page->Free(allocation.baseVertex, allocation.vertexCount, allocation.firstIndex, allocation.indexCount);
+    if (allocation.page->Empty())
+    {
+        auto it = std::find(pages.begin(), pages.end(), allocation.page);
+        if (it != pages.end())
+        {
+            std::cout << "[GeometryArena] released empty page: " << allocation.page->vertexCapacity << " vertices, "
+                      << allocation.page->indexCapacity << " indices" << std::endl;
+            pages.erase(it);
+        }
+    }
+    allocation.page.reset();
+}
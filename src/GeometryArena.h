@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include "VertexFormat.h"
+
+// 一页共享的顶点/索引缓冲区和对应的VAO。同一页里的mesh顶点格式和索引类型相同，
+// 可以用baseVertex/firstIndex区分，合并到一次glMultiDrawElementsIndirect中
+class GeometryPage
+{
+public:
+    GeometryPage(VertexFormat format, int indexSize, size_t vertexCapacity, size_t indexCapacity);
+    ~GeometryPage();
+    GeometryPage(const GeometryPage &) = delete;
+    GeometryPage &operator=(const GeometryPage &) = delete;
+
+    // 单位为顶点/索引个数，空间不够时返回false
+    bool Allocate(size_t vertexCount, size_t indexCount, size_t &baseVertex, size_t &firstIndex);
+    void Free(size_t baseVertex, size_t vertexCount, size_t firstIndex, size_t indexCount);
+    // 写入已分配的区间，data为当前格式下的顶点/索引数组
+    void UploadVertices(size_t baseVertex, const void *data, size_t vertexCount);
+    void UploadIndices(size_t firstIndex, const void *data, size_t indexCount);
+    // 没有任何mesh占用
+    bool Empty() const { return allocationCount == 0; }
+    // 对应indexSize的GL类型（GL_UNSIGNED_SHORT/GL_UNSIGNED_INT）
+    GLenum IndexType() const { return indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+
+    const VertexFormat format;
+    const int indexSize;
+    const size_t vertexCapacity;
+    const size_t indexCapacity;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+
+private:
+    // 首次适配的空闲区间表 offset -> count，释放时与相邻区间合并
+    struct FreeList
+    {
+        std::map<size_t, size_t> blocks;
+        bool Allocate(size_t count, size_t &offset);
+        void Free(size_t offset, size_t count);
+    };
+    FreeList freeVertices;
+    FreeList freeIndices;
+    size_t allocationCount = 0;
+};
+
+// mesh在某一页中占用的区间；page为空表示还没有上传
+struct GeometryAllocation
+{
+    std::shared_ptr<GeometryPage> page;
+    unsigned int baseVertex = 0;
+    unsigned int firstIndex = 0;
+    unsigned int vertexCount = 0;
+    unsigned int indexCount = 0;
+};
+
+// 按(顶点格式, 索引字节数)分页管理所有mesh的GPU几何数据，必须在主线程使用
+class GeometryArena
+{
+public:
+    // 每页的默认容量，更大的mesh单独占一页
+    static constexpr size_t PAGE_VERTEX_BYTES = 16 << 20;
+    static constexpr size_t PAGE_INDEX_BYTES = 16 << 20;
+
+    static GeometryArena &Instance()
+    {
+        static GeometryArena instance;
+        return instance;
+    }
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    // 在对应的页中分配，现有页都放不下时新建一页
+    GeometryAllocation Allocate(VertexFormat format, int indexSize, size_t vertexCount, size_t indexCount);
+    // 页空了以后从pages中移除，最后一个引用释放时删除GL缓冲区（大mesh单独的页不会一直占着显存）
+    void Free(GeometryAllocation &allocation);
+    size_t PageCount() const { return pages.size(); }
+    // 放弃对所有页的引用，仍被mesh持有的页在mesh析构时释放；需在GL上下文销毁前调用
+    void Release() { pages.clear(); }
+
+private:
+    GeometryArena() = default;
+    std::vector<std::shared_ptr<GeometryPage>> pages;
+};
@@ -0,0 +1,81 @@
+#include "ImportService.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+ImportService::~ImportService()
+{
+    Shutdown();
+}
+
+void ImportService::Shutdown()
+{
+    stopping = true;
+    std::vector<JobHandle> running;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        running.swap(jobs);
+    }
+    for (JobHandle job : running)
+    {
+        JobSystem::Instance().Wait(job);
+    }
+
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completed.clear();
+    pending = 0;
+    deliverSequence = submitSequence;
+    stopping = false;
+}
+
+void ImportService::Submit(const std::shared_ptr<Model> &model)
+{
+    pending++;
+    uint64_t sequence = submitSequence++;
+    // 后台任务：主线程Wait()时不会被一次导入卡住
+    JobHandle job = JobSystem::Instance().Schedule([this, model, sequence]
+                                                   { Import(model, sequence); },
+                                                   {}, JobAffinity::Background);
+
+    std::lock_guard<std::mutex> lock(jobMutex);
+    JobSystem &jobSystem = JobSystem::Instance();
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [&](JobHandle handle)
+                              { return jobSystem.IsDone(handle); }),
+               jobs.end());
+    jobs.push_back(job);
+}
+
+void ImportService::PollCompleted(std::vector<ImportResult> &out)
+{
+    std::lock_guard<std::mutex> lock(completedMutex);
+    if (completed.empty())
+        return;
+
+    std::sort(completed.begin(), completed.end(), [](const ImportResult &a, const ImportResult &b)
+              { return a.sequence < b.sequence; });
+    size_t delivered = 0;
+    while (delivered < completed.size() && completed[delivered].sequence == deliverSequence)
+    {
+        out.push_back(std::move(completed[delivered]));
+        delivered++;
+        deliverSequence++;
+    }
+    completed.erase(completed.begin(), completed.begin() + delivered);
+    pending -= (int)delivered;
+}
+
+void ImportService::Import(const std::shared_ptr<Model> &model, uint64_t sequence)
+{
+    if (stopping)
+        return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ImportResult result;
+    result.model = model;
+    result.sequence = sequence;
+    result.success = model->load();
+    result.seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completed.push_back(std::move(result));
+}
\ No newline at end of file
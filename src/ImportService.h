@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Model.h"
+#include "JobSystem.h"
+
+struct ImportResult
+{
+    std::shared_ptr<Model> model;
+    bool success = false;
+    float seconds = 0.0f; // 工作线程上的耗时
+    uint64_t sequence = 0; // 提交顺序
+};
+
+// 模型异步导入服务
+// 每个模型一个JobSystem任务，负责Assimp解析、顶点交错和rig解析（内部的ParallelFor由其他工作线程分担），完成后放入完成队列
+// 主线程每帧调用PollCompleted()取回结果，再调用Model::upload()上传GPU
+// 结果按提交顺序交付（先提交的还没完成时后面的先留在队列里），上传顺序以及Mesh的id因此与线程调度无关
+class ImportService
+{
+public:
+    static ImportService &Instance()
+    {
+        static ImportService instance;
+        return instance;
+    }
+    ImportService(const ImportService &) = delete;
+    ImportService &operator=(const ImportService &) = delete;
+    ~ImportService();
+
+    // 丢弃还没开始的导入，等待正在进行的导入结束；需在JobSystem::Shutdown()之前调用
+    void Shutdown();
+
+    // 主线程调用：提交一个已经设置好directory/filename/rigFile的Model
+    void Submit(const std::shared_ptr<Model> &model);
+
+    // 主线程调用：按提交顺序取出已完成的导入结果（追加到out）
+    void PollCompleted(std::vector<ImportResult> &out);
+
+    // 已提交但还未被PollCompleted取走的任务数
+    int PendingCount() const { return pending.load(); }
+
+private:
+    ImportService() = default;
+
+    void Import(const std::shared_ptr<Model> &model, uint64_t sequence);
+
+    std::mutex jobMutex;
+    std::vector<JobHandle> jobs; // 已提交的导入任务，Submit时清理已完成的
+    std::atomic<bool> stopping = false;
+
+    std::mutex completedMutex;
+    std::vector<ImportResult> completed;
+    // 主线程使用：下一个提交的序号、下一个要交付的序号
+    uint64_t submitSequence = 0;
+    uint64_t deliverSequence = 0;
+
+    std::atomic<int> pending = 0;
+};
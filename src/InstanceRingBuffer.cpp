@@ -0,0 +1,98 @@
+#include "InstanceRingBuffer.h"
+#include "GLState.h"
+#include <iostream>
+#include <algorithm>
+
+static constexpr size_t MIN_FRAME_BYTES = 1 << 20; // 每段至少1MB（16384个mat4）
+
+void InstanceRingBuffer::WaitFence(int index)
+{
+    if (!fences[index])
+        return;
+    // 正常情况下两帧前的命令早已完成，这里几乎不会阻塞
+    GLenum result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+    }
+    glDeleteSync(fences[index]);
+    fences[index] = nullptr;
+}
+
+void InstanceRingBuffer::Create(size_t bytesPerFrame)
+{
+    Release();
+
+    frameBytes = bytesPerFrame;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, frameBytes * FRAME_COUNT, nullptr, flags);
+    mapped = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, frameBytes * FRAME_COUNT, flags);
+    if (!mapped)
+    {
+        std::cout << "[InstanceRingBuffer] failed to map persistent buffer" << std::endl;
+    }
+}
+
+void InstanceRingBuffer::BeginFrame(size_t requiredBytes)
+{
+    if (buffer == 0 || requiredBytes > frameBytes)
+    {
+        size_t bytes = std::max(MIN_FRAME_BYTES, frameBytes);
+        while (bytes < requiredBytes)
+            bytes *= 2;
+        if (buffer != 0)
+        {
+            std::cout << "[InstanceRingBuffer] grow to " << bytes / 1024 << "KB per frame" << std::endl;
+        }
+        // 扩容前等所有段的GPU读取结束
+        for (int i = 0; i < FRAME_COUNT; i++)
+            WaitFence(i);
+        Create(bytes);
+    }
+
+    WaitFence(frame);
+    frameOffset = 0;
+}
+
+void *InstanceRingBuffer::Allocate(size_t bytes, size_t alignment, size_t &offset)
+{
+    size_t aligned = (frameOffset + alignment - 1) / alignment * alignment;
+    if (!mapped || aligned + bytes > frameBytes)
+        return nullptr;
+    frameOffset = aligned + bytes;
+    offset = frame * frameBytes + aligned;
+    return mapped + offset;
+}
+
+void InstanceRingBuffer::EndFrame()
+{
+    if (buffer == 0)
+        return;
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame = (frame + 1) % FRAME_COUNT;
+}
+
+void InstanceRingBuffer::Release()
+{
+    for (int i = 0; i < FRAME_COUNT; i++)
+    {
+        if (fences[i])
+        {
+            glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+    }
+    if (buffer)
+    {
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        GLState::Instance().ForgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+    frameBytes = 0;
+    frameOffset = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+
+// 持久映射（GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT）的三缓冲环形缓冲区，存放逐实例/逐绘制数据和间接绘制命令
+// 每帧使用其中一段，段之间用fence同步：CPU写第N帧时GPU可能还在读N-1、N-2帧
+// 只在容量不够时重新分配，稳态下没有同步查询和重新分配；必须在主线程使用
+class InstanceRingBuffer
+{
+public:
+    static constexpr int FRAME_COUNT = 3;
+
+    InstanceRingBuffer() = default;
+    ~InstanceRingBuffer() = default;
+    InstanceRingBuffer(const InstanceRingBuffer &) = delete;
+    InstanceRingBuffer &operator=(const InstanceRingBuffer &) = delete;
+
+    // 等待当前段的GPU读取完成，requiredBytes为本帧需要的总字节数，超过段大小时扩容
+    void BeginFrame(size_t requiredBytes);
+    // 在当前段中分配bytes字节，返回写入地址；offset为相对整个缓冲区起始的字节偏移
+    void *Allocate(size_t bytes, size_t alignment, size_t &offset);
+    // 为当前段插入fence并切换到下一段
+    void EndFrame();
+    // 释放GL资源，需在GL上下文销毁前调用
+    void Release();
+
+    GLuint Buffer() const { return buffer; }
+    // 当前段相对缓冲区起始的字节偏移和段大小，用于把整段绑定到SSBO
+    size_t FrameBase() const { return frame * frameBytes; }
+    size_t FrameBytes() const { return frameBytes; }
+
+private:
+    void Create(size_t bytesPerFrame);
+    void WaitFence(int frame);
+
+    GLuint buffer = 0;
+    unsigned char *mapped = nullptr;
+    size_t frameBytes = 0; // 每段大小
+    size_t frameOffset = 0; // 当前段已分配的字节数
+    int frame = 0;
+    GLsync fences[FRAME_COUNT] = {};
+};
@@ -0,0 +1,398 @@
+#include "JobSystem.h"
+#include <cassert>
+#include <iostream>
+
+// 当前线程在queues中的下标，主线程为0，不属于JobSystem的线程为-1
+static thread_local int threadIndex = -1;
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+unsigned int JobSystem::DefaultThreadCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void JobSystem::Start(int workerCount)
+{
+    if (running)
+        return;
+
+    if (workerCount < 0)
+    {
+        unsigned int cores = DefaultThreadCount();
+        workerCount = cores > 1 ? (int)cores - 1 : 1; // 主线程也执行任务
+    }
+
+    threadIndex = 0;
+    stopping = false;
+    queues.clear();
+    for (int i = 0; i <= workerCount; i++)
+        queues.push_back(std::make_unique<WorkQueue>());
+    for (int i = 1; i <= workerCount; i++)
+        workers.emplace_back(&JobSystem::WorkerLoop, this, (unsigned int)i);
+    running = true;
+    std::cout << "[JobSystem] started " << workerCount << " workers" << std::endl;
+}
+
+void JobSystem::Shutdown()
+{
+    if (!running)
+        return;
+
+    // 先执行完已经排队的任务（例如截图的后台编码），当前线程也参与
+    while (true)
+    {
+        if (threadIndex == 0)
+            RunMainThreadJobs();
+        if (Job *job = Take())
+        {
+            Execute(job);
+            continue;
+        }
+        if (queuedJobs.load(std::memory_order_acquire) == 0)
+            break;
+        std::this_thread::yield();
+    }
+
+    // running保持为true直到工作线程全部退出：仍在执行的任务可能还会创建任务，不能触发Start()
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (auto &worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+
+    // 丢弃工作线程退出前才提交、还在队列里的任务
+    size_t dropped = 0;
+    auto drop = [&dropped](WorkQueue &queue)
+    {
+        while (Job *job = queue.Pop())
+        {
+            job->destroy(job);
+            job->inUse.store(false, std::memory_order_release);
+            dropped++;
+        }
+    };
+    for (auto &queue : queues)
+        drop(*queue);
+    drop(mainQueue);
+    drop(backgroundQueue);
+    for (auto *overflow : {&mainOverflow, &backgroundOverflow})
+    {
+        for (Job *job : *overflow)
+        {
+            job->destroy(job);
+            job->inUse.store(false, std::memory_order_release);
+            dropped++;
+        }
+        overflow->clear();
+    }
+    queuedJobs = 0;
+    running = false;
+    if (dropped > 0)
+        std::cout << "[JobSystem] dropped " << dropped << " job(s) submitted during shutdown" << std::endl;
+}
+
+bool JobSystem::WorkQueue::Push(Job *job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size == QUEUE_CAPACITY)
+        return false;
+    jobs[(head + size) % QUEUE_CAPACITY] = job;
+    size++;
+    return true;
+}
+
+Job *JobSystem::WorkQueue::Pop()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size == 0)
+        return nullptr;
+    size--;
+    return jobs[(head + size) % QUEUE_CAPACITY];
+}
+
+Job *JobSystem::WorkQueue::Steal()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size == 0)
+        return nullptr;
+    Job *job = jobs[head];
+    head = (head + 1) % QUEUE_CAPACITY;
+    size--;
+    return job;
+}
+
+Job *JobSystem::Allocate(JobHandle parent, JobAffinity affinity)
+{
+    if (!running)
+    {
+        // 只允许拥有JobSystem的线程（主线程或还没启动时的调用线程）自动启动，Shutdown()期间不允许
+        assert(threadIndex <= 0 && !stopping.load());
+        Start();
+    }
+    // 没有工作线程时后台任务也由Wait()的线程执行
+    if (affinity == JobAffinity::Background && workers.empty())
+        affinity = JobAffinity::Any;
+
+    // 环形查找空闲槽位，长时间运行的任务（例如导入）占着的槽位直接跳过
+    Job *job = nullptr;
+    while (!job)
+    {
+        for (size_t attempt = 0; attempt < POOL_SIZE; attempt++)
+        {
+            Job *candidate = &pool[poolCursor.fetch_add(1, std::memory_order_relaxed) % POOL_SIZE];
+            bool expected = false;
+            if (candidate->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                job = candidate;
+                break;
+            }
+        }
+        if (!job)
+        {
+            // 池已满：先执行别的任务腾出槽位
+            if (Job *other = Take())
+                Execute(other);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    while (job->lock.test_and_set(std::memory_order_acquire))
+        ;
+    job->generation.fetch_add(1, std::memory_order_relaxed);
+    job->completed = false;
+    job->continuationCount = 0;
+    job->lock.clear(std::memory_order_release);
+
+    job->affinity = affinity;
+    job->trackAllocations = AllocationCounter::trackingDepth > 0;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    job->dependencies.store(1, std::memory_order_relaxed); // Run()时减掉
+    job->parent = nullptr;
+    if (parent.job && !IsDone(parent))
+    {
+        job->parent = parent.job;
+        parent.job->unfinished.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::AddDependency(JobHandle job, JobHandle dependency)
+{
+    Job *target = dependency.job;
+    if (!target)
+        return;
+
+    while (target->lock.test_and_set(std::memory_order_acquire))
+        ;
+    bool pending = target->generation.load(std::memory_order_relaxed) == dependency.generation && !target->completed;
+    if (pending)
+    {
+        if (target->continuationCount == Job::MAX_CONTINUATIONS)
+        {
+            target->lock.clear(std::memory_order_release);
+            std::cout << "[JobSystem] too many continuations, waiting for dependency inline" << std::endl;
+            Wait(dependency);
+            return;
+        }
+        job.job->dependencies.fetch_add(1, std::memory_order_relaxed);
+        target->continuations[target->continuationCount++] = job.job;
+    }
+    target->lock.clear(std::memory_order_release);
+}
+
+void JobSystem::Run(JobHandle job)
+{
+    if (job.job->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        Push(job.job);
+}
+
+void JobSystem::Push(Job *job)
+{
+    if (job->affinity == JobAffinity::MainThread)
+    {
+        if (!mainQueue.Push(job))
+        {
+            std::lock_guard<std::mutex> lock(mainQueue.mutex);
+            mainOverflow.push_back(job);
+        }
+        return;
+    }
+
+    if (job->affinity == JobAffinity::Background)
+    {
+        if (!backgroundQueue.Push(job))
+        {
+            std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+            backgroundOverflow.push_back(job);
+        }
+    }
+    else
+    {
+        WorkQueue &queue = *queues[threadIndex >= 0 ? threadIndex : 0];
+        if (!queue.Push(job))
+        {
+            // 队列满时直接执行，相当于背压
+            Execute(job);
+            return;
+        }
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        // 加锁后通知，避免工作线程检查完条件、还没睡下时丢失唤醒
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+Job *JobSystem::TakeMainThreadJob()
+{
+    if (Job *job = mainQueue.Steal())
+        return job;
+    std::lock_guard<std::mutex> lock(mainQueue.mutex);
+    if (mainOverflow.empty())
+        return nullptr;
+    Job *job = mainOverflow.back();
+    mainOverflow.pop_back();
+    return job;
+}
+
+Job *JobSystem::Take(bool allowBackground)
+{
+    if (threadIndex == 0)
+    {
+        if (Job *job = TakeMainThreadJob())
+            return job;
+    }
+
+    size_t queueCount = queues.size();
+    if (queueCount == 0)
+        return nullptr;
+    size_t self = threadIndex >= 0 ? (size_t)threadIndex : 0;
+    if (threadIndex >= 0)
+    {
+        if (Job *job = queues[self]->Pop())
+        {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    for (size_t i = 1; i <= queueCount; i++)
+    {
+        WorkQueue &victim = *queues[(self + i) % queueCount];
+        if (Job *job = victim.Steal())
+        {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    if (allowBackground && threadIndex > 0)
+    {
+        Job *job = backgroundQueue.Steal();
+        if (!job)
+        {
+            std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+            if (!backgroundOverflow.empty())
+            {
+                job = backgroundOverflow.back();
+                backgroundOverflow.pop_back();
+            }
+        }
+        if (job)
+        {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(Job *job)
+{
+    // 按创建任务时的状态统计分配，Wait()中顺带执行的无关任务不计入调用方
+    int trackingDepth = AllocationCounter::trackingDepth;
+    AllocationCounter::trackingDepth = job->trackAllocations ? 1 : 0;
+    job->invoke(job);
+    job->destroy(job);
+    AllocationCounter::trackingDepth = trackingDepth;
+    Finish(job);
+}
+
+void JobSystem::Finish(Job *job)
+{
+    while (job)
+    {
+        if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        // 自身和所有子任务都完成：取出后续任务后释放槽位，之后不能再访问job
+        Job *parent = job->parent;
+        Job *continuations[Job::MAX_CONTINUATIONS];
+        while (job->lock.test_and_set(std::memory_order_acquire))
+            ;
+        job->completed = true;
+        int continuationCount = job->continuationCount;
+        std::copy(job->continuations, job->continuations + continuationCount, continuations);
+        job->lock.clear(std::memory_order_release);
+        job->inUse.store(false, std::memory_order_release);
+
+        for (int i = 0; i < continuationCount; i++)
+        {
+            if (continuations[i]->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                Push(continuations[i]);
+        }
+        job = parent;
+    }
+}
+
+bool JobSystem::IsDone(JobHandle handle) const
+{
+    if (!handle.job)
+        return true;
+    return handle.job->generation.load(std::memory_order_acquire) != handle.generation ||
+           handle.job->unfinished.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::Wait(JobHandle handle)
+{
+    while (!IsDone(handle))
+    {
+        if (Job *job = Take())
+            Execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    while (Job *job = TakeMainThreadJob())
+        Execute(job);
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+    threadIndex = (int)index;
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        if (Job *job = Take(true))
+        {
+            Execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this]
+                            { return stopping.load() || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AllocationCounter.h"
+
+// 任务在哪些线程上执行
+enum class JobAffinity : uint8_t
+{
+    Any,        // 任意线程，包括在Wait()中的线程
+    MainThread, // 只在主线程，用于GL调用
+    Background, // 只由空闲的工作线程执行，用于耗时长的任务（例如导入）；任何线程在Wait()中都不会取它，不会被它卡住
+};
+
+// 任务对象，放在JobSystem的固定大小池中；可调用对象原地构造在payload里，提交任务不分配堆内存
+struct Job
+{
+    static constexpr size_t PAYLOAD_SIZE = 64;
+    static constexpr int MAX_CONTINUATIONS = 8;
+
+    alignas(std::max_align_t) unsigned char payload[PAYLOAD_SIZE];
+    void (*invoke)(Job *) = nullptr;
+    void (*destroy)(Job *) = nullptr;
+
+    Job *parent = nullptr;
+    std::atomic<int> unfinished{0};   // 自身 + 未完成的子任务
+    std::atomic<int> dependencies{0}; // 未完成的前置任务 + 还没有Run()
+    std::atomic<uint32_t> generation{0};
+    std::atomic<bool> inUse{false};
+    JobAffinity affinity = JobAffinity::Any;
+    bool trackAllocations = false; // 创建时处于AllocationCounter::TrackScope中
+
+    // 完成后要释放的后续任务，lock保护continuations/completed
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    bool completed = false;
+    int continuationCount = 0;
+    Job *continuations[MAX_CONTINUATIONS];
+};
+
+// 任务句柄，任务完成后槽位可能被复用，generation不同即视为已完成
+struct JobHandle
+{
+    Job *job = nullptr;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return job != nullptr; }
+};
+
+// 工作窃取任务调度器
+// 每个线程（主线程为0，工作线程为1..N）一个双端队列：自己从尾部取（LIFO，缓存友好），空闲线程从别人头部偷
+// 任务可以有父任务（父任务在所有子任务完成后才算完成）和前置任务（全部完成后才开始执行）
+// MainThread任务只由主线程在RunMainThreadJobs()或Wait()中执行；Background任务放在单独的队列，只由工作线程执行
+// Wait()在等待期间会执行其他任务，因此任务中可以嵌套ParallelFor
+class JobSystem
+{
+public:
+    static constexpr size_t POOL_SIZE = 16384;
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    static JobSystem &Instance()
+    {
+        static JobSystem instance;
+        return instance;
+    }
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+    ~JobSystem();
+
+    // 在主线程调用；workerCount为负时使用 hardware_concurrency - 1，第一次提交任务时会自动启动
+    // workerCount为0时所有任务都在Wait()的线程上执行（Background任务也是），用于单线程对比
+    void Start(int workerCount = -1);
+    // 在主线程调用：先执行完已经排队的任务（当前线程也参与），再停止工作线程
+    // 这期间新提交、没来得及执行的任务被丢弃并输出日志
+    void Shutdown();
+    bool IsRunning() const { return running; }
+    // 参与执行任务的线程数（工作线程 + 主线程）
+    unsigned int ThreadCount() const { return (unsigned int)workers.size() + 1; }
+
+    // 创建任务但不执行，可以再添加前置任务，之后调用Run()
+    template <typename Func>
+    JobHandle Create(Func &&func, JobHandle parent = {}, JobAffinity affinity = JobAffinity::Any)
+    {
+        using Callable = std::decay_t<Func>;
+        static_assert(sizeof(Callable) <= Job::PAYLOAD_SIZE, "job capture too large, capture by pointer instead");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "job capture over-aligned");
+
+        Job *job = Allocate(parent, affinity);
+        new (job->payload) Callable(std::forward<Func>(func));
+        job->invoke = [](Job *self)
+        { (*std::launder(reinterpret_cast<Callable *>(self->payload)))(); };
+        job->destroy = [](Job *self)
+        { std::launder(reinterpret_cast<Callable *>(self->payload))->~Callable(); };
+        return {job, job->generation.load(std::memory_order_relaxed)};
+    }
+
+    // job在dependency完成后才执行；需在Run(job)之前调用
+    // dependency须已经Run()：它的后续任务超过MAX_CONTINUATIONS时会在当前线程Wait(dependency)，还没Run()会死锁
+    void AddDependency(JobHandle job, JobHandle dependency);
+    // 前置任务都完成后放入队列
+    void Run(JobHandle job);
+    // 创建并立即执行
+    template <typename Func>
+    JobHandle Schedule(Func &&func, JobHandle parent = {}, JobAffinity affinity = JobAffinity::Any)
+    {
+        JobHandle handle = Create(std::forward<Func>(func), parent, affinity);
+        Run(handle);
+        return handle;
+    }
+
+    bool IsDone(JobHandle handle) const;
+    // 等待期间执行其他任务
+    void Wait(JobHandle handle);
+
+    // 主线程每帧调用，执行所有主线程任务
+    void RunMainThreadJobs();
+
+    // 把[begin, end)切成至少grain个元素的块并行执行 func(chunkBegin, chunkEnd)，返回时全部完成
+    // 块数少于2时直接在当前线程执行
+    template <typename Func>
+    void ParallelFor(size_t begin, size_t end, size_t grain, Func &&func)
+    {
+        if (end <= begin)
+            return;
+        size_t count = end - begin;
+        grain = std::max<size_t>(grain, 1);
+        // 每个线程分几块，负载不均时可以互相偷
+        size_t maxChunks = (size_t)(IsRunning() ? ThreadCount() : DefaultThreadCount()) * 4;
+        size_t chunks = std::min(maxChunks, (count + grain - 1) / grain);
+        if (chunks <= 1)
+        {
+            func(begin, end);
+            return;
+        }
+
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        auto *callable = &func;
+        JobHandle root = Create([] {});
+        for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += chunkSize)
+        {
+            size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+            Schedule([callable, chunkBegin, chunkEnd]
+                     { (*callable)(chunkBegin, chunkEnd); },
+                     root);
+        }
+        Run(root);
+        Wait(root);
+    }
+
+private:
+    JobSystem() = default;
+
+    // 固定容量的环形双端队列，用互斥锁保护
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        Job *jobs[QUEUE_CAPACITY];
+        size_t head = 0; // 被偷的一端
+        size_t size = 0;
+
+        bool Push(Job *job);
+        Job *Pop();   // 尾部，所有者调用
+        Job *Steal(); // 头部，其他线程调用
+    };
+
+    static unsigned int DefaultThreadCount();
+
+    Job *Allocate(JobHandle parent, JobAffinity affinity);
+    void Push(Job *job);
+    // mainQueue为空时再看mainOverflow
+    Job *TakeMainThreadJob();
+    // 按 主线程任务（仅主线程）-> 自己的队列 -> 其他线程的队列 -> 后台任务 顺序取一个任务
+    // allowBackground只在工作线程的顶层循环中为true，Wait()等嵌套等待中不取后台任务
+    Job *Take(bool allowBackground = false);
+    void Execute(Job *job);
+    void Finish(Job *job);
+    void WorkerLoop(unsigned int index);
+
+    std::atomic<bool> running{false};
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    WorkQueue mainQueue;
+    std::vector<Job *> mainOverflow; // mainQueue满时暂存，由mainQueue.mutex保护
+    WorkQueue backgroundQueue;
+    std::vector<Job *> backgroundOverflow; // 同上，由backgroundQueue.mutex保护
+
+    Job pool[POOL_SIZE];
+    std::atomic<size_t> poolCursor{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<int> queuedJobs{0};
+    std::atomic<bool> stopping{false};
+};
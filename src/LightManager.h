@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <GL/glew.h>
 #include "Light.h"
+#include "GLState.h"
 
 constexpr int MAX_LIGHTS = 32;
 
@@ -45,9 +46,8 @@ public:
     LightManager()
     {
         glGenBuffers(1, &ubo);
-        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        GLState::Instance().BindBuffer(GL_UNIFORM_BUFFER, ubo);
         glBufferData(GL_UNIFORM_BUFFER, sizeof(LightUBO), nullptr, GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
     void AddLight(const std::shared_ptr<Light> &l)
@@ -124,13 +124,12 @@ public:
             }
         }
 
-        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        GLState::Instance().BindBuffer(GL_UNIFORM_BUFFER, ubo);
         glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightUBO), &uboData);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
     void BindToShader(int bindingPoint)
     {
-        glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo);
+        GLState::Instance().BindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo);
     }
 };
@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+
+    // 允许其他句柄在映射期间写入和改名（MeshCache会刷新缓存文件头、把旧缓存移开）
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    size = (size_t)fileSize.QuadPart;
+    opened = true;
+    if (size == 0)
+        return true;
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+        Close();
+        return false;
+    }
+
+    data = (unsigned char *)MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+    if (!data)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    data = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    size = 0;
+    opened = false;
+}
+#else
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    opened = true;
+    if (size > 0)
+    {
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED)
+        {
+            close(fd);
+            size = 0;
+            opened = false;
+            return false;
+        }
+        data = (unsigned char *)ptr;
+    }
+    // 映射建立后就可以关闭文件描述符
+    close(fd);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data)
+        munmap(data, size);
+    data = nullptr;
+    size = 0;
+    opened = false;
+}
+#endif
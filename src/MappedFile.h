@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// 只读方式打开文件并映射到内存（写时复制，修改映射内容不会写回文件）
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    bool IsOpen() const { return opened; }
+    unsigned char *Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    unsigned char *data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
@@ -1,32 +1,78 @@
 #include "Material.h"
 #include <GL/glew.h>
+#include "GLState.h"
+#include <iostream>
 
-void Material::ApplyUniforms()
+static constexpr uint32_t ID_MATERIAL_BLOCK = Shader::PropertyToID("MaterialBlock");
+
+Material::Material(std::shared_ptr<Shader> shader) : shader(std::move(shader))
 {
-    shader->SetUniforms(uniforms);
+    layout = this->shader->GetBlockLayout(ID_MATERIAL_BLOCK);
+    if (layout)
+        block.assign(layout->size, 0);
 }
 
-void Material::ApplyRenderState()
+Material::~Material()
+{
+    if (ubo)
+    {
+        GLState::Instance().ForgetBuffer(ubo);
+        glDeleteBuffers(1, &ubo);
+    }
+}
+
+const UniformBlockMember *Material::FindParam(uint32_t id, GLenum type)
 {
-    if (renderState.depthTest)
+    const UniformBlockMember *member = nullptr;
+    if (layout)
     {
-        glEnable(GL_DEPTH_TEST);
+        auto it = layout->members.find(id);
+        if (it != layout->members.end())
+            member = &it->second;
     }
-    else
-        glDisable(GL_DEPTH_TEST);
+    if (member && member->type == type)
+        return member;
 
-    glDepthFunc(renderState.depthFunc);
-    glDepthMask(renderState.depthWrite ? GL_TRUE : GL_FALSE);
+    if (warnedParams.insert(id).second)
+    {
+        if (!member)
+            std::cout << "material parameter " << id << " not found in MaterialBlock" << std::endl;
+        else
+            std::cout << "material parameter " << id << " type mismatch: shader 0x" << std::hex << member->type
+                      << ", value 0x" << type << std::dec << std::endl;
+    }
+    return nullptr;
+}
 
-    if (renderState.blend)
-        glEnable(GL_BLEND);
-    else
-        glDisable(GL_BLEND);
+void Material::ApplyUniforms()
+{
+    if (block.empty())
+        return;
 
-    if (renderState.cullFace)
-        glEnable(GL_CULL_FACE);
-    else
-        glDisable(GL_CULL_FACE);
+    GLState &state = GLState::Instance();
+    if (!ubo)
+    {
+        glGenBuffers(1, &ubo);
+        state.BindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, block.size(), block.data(), GL_DYNAMIC_DRAW);
+        dirty = false;
+    }
+    else if (dirty)
+    {
+        state.BindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, block.size(), block.data());
+        dirty = false;
+    }
+    state.BindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BINDING, ubo, 0, (GLsizeiptr)block.size());
+}
 
-    glBlendFunc(renderState.blendSrc, renderState.blendDst);
+void Material::ApplyRenderState()
+{
+    GLState &state = GLState::Instance();
+    state.SetDepthTest(renderState.depthTest);
+    state.SetDepthFunc(renderState.depthFunc);
+    state.SetDepthWrite(renderState.depthWrite);
+    state.SetBlend(renderState.blend);
+    state.SetCullFace(renderState.cullFace);
+    state.SetBlendFunc(renderState.blendSrc, renderState.blendDst);
 }
@@ -1,11 +1,15 @@
 #pragma once
-#include <unordered_map>
+#include <unordered_set>
 #include <string>
-#include <any>
+#include <string_view>
+#include <vector>
 #include <memory>
+#include <cstring>
 #include <GL/glew.h>
 
 #include "Shader.h"
+#include "ObjectId.h"
+#include <glm/glm.hpp>
 
 struct RenderState
 {
@@ -27,23 +31,74 @@ enum RenderQueue
     Overlay = 4000
 };
 
+// 材质参数类型到GL类型的映射，只允许这些编译期类型
+template <typename T>
+struct MaterialParamType;
+template <>
+struct MaterialParamType<float> { static constexpr GLenum value = GL_FLOAT; };
+template <>
+struct MaterialParamType<int> { static constexpr GLenum value = GL_INT; };
+template <>
+struct MaterialParamType<unsigned int> { static constexpr GLenum value = GL_UNSIGNED_INT; };
+template <>
+struct MaterialParamType<glm::vec2> { static constexpr GLenum value = GL_FLOAT_VEC2; };
+template <>
+struct MaterialParamType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+template <>
+struct MaterialParamType<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+template <>
+struct MaterialParamType<glm::ivec2> { static constexpr GLenum value = GL_INT_VEC2; };
+template <>
+struct MaterialParamType<glm::ivec3> { static constexpr GLenum value = GL_INT_VEC3; };
+template <>
+struct MaterialParamType<glm::ivec4> { static constexpr GLenum value = GL_INT_VEC4; };
+template <>
+struct MaterialParamType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+// 材质参数保存在着色器中的 layout(std140) uniform MaterialBlock 里
+// 偏移来自shader的反射，参数直接写进按std140打包的block，脏了才上传到材质自己的UBO
+// 应用材质时只需要一次glBindBufferRange（绑定点MATERIAL_BINDING）
 class Material
 {
     std::shared_ptr<Shader> shader;
-    std::unordered_map<std::string, std::pair<std::string, std::any>> uniforms;
+    const UniformBlockLayout *layout = nullptr;
+    std::vector<unsigned char> block; // std140打包后的参数
+    bool dirty = true;
+    GLuint ubo = 0;
+    std::unordered_set<uint32_t> warnedParams;
+
+    // 查找参数在block中的位置，不存在或类型不符时警告一次并返回nullptr
+    const UniformBlockMember *FindParam(uint32_t id, GLenum type);
 
 public:
+    const unsigned int id = NextObjectId<Material>(); // 见Renderer的排序键
     RenderState renderState;
     unsigned int renderQueue = RenderQueue::Geometry;
 
-    Material(std::shared_ptr<Shader> shader) : shader(std::move(shader)) {}
+    Material(std::shared_ptr<Shader> shader);
+    ~Material();
+    Material(const Material &) = delete;
+    Material &operator=(const Material &) = delete;
 
-    void SetUniform(const std::string &name, const std::string &type, const std::any &value)
+    template <typename T>
+    void SetParam(uint32_t id, const T &value)
     {
-        uniforms[name] = {type, value};
+        if (const UniformBlockMember *member = FindParam(id, MaterialParamType<T>::value))
+        {
+            // std140中vec3占16字节，mat4按列存放，都与glm的内存布局兼容
+            std::memcpy(block.data() + member->offset, &value, sizeof(T));
+            dirty = true;
+        }
     }
-    std::shared_ptr<Shader> GetShader() const { return shader; }
+    template <typename T>
+    void SetParam(std::string_view name, const T &value)
+    {
+        SetParam(Shader::PropertyToID(name), value);
+    }
+
+    const std::shared_ptr<Shader> &GetShader() const { return shader; }
 
+    // 上传（如果脏了）并绑定参数block
     void ApplyUniforms();
     void ApplyRenderState();
 };
@@ -1,12 +1,23 @@
 #include "Mesh.h"
+#include "VertexInterleave.h"
 
 #include <GL/glew.h>
+#include "GLState.h"
+#include "Parallel.h"
 #include <stb_image.h>
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <mutex>
 #include <glm/glm.hpp>
 
+// 计算包围盒/包围球时每个并行块至少处理的顶点数
+static constexpr size_t BOUNDS_GRAIN = 1 << 16;
+
 Mesh::Mesh(aiMesh *mesh, const aiScene *scence, const std::string &dict)
-    : vertices(nullptr), indices(nullptr), vao(0), vbo(0), ibo(0), instanceVBO(0)
+    : vertices(nullptr), indices(nullptr)
 {
     v_num = mesh->mNumVertices;
     i_num = mesh->mNumFaces * 3;
@@ -15,47 +26,8 @@ Mesh::Mesh(aiMesh *mesh, const aiScene *scence, const std::string &dict)
     vertices = new float[v_size];
     indices = new unsigned int[i_size];
 
-    for (int i = 0; i < mesh->mNumVertices; i++)
-    {
-        try
-        {
-            vertices[i * 8 + 0] = mesh->mVertices[i].x;
-            vertices[i * 8 + 1] = mesh->mVertices[i].y;
-            vertices[i * 8 + 2] = mesh->mVertices[i].z;
-            vertices[i * 8 + 3] = mesh->mNormals[i].x;
-            vertices[i * 8 + 4] = mesh->mNormals[i].y;
-            vertices[i * 8 + 5] = mesh->mNormals[i].z;
-            if (mesh->mTextureCoords[0])
-            {
-                vertices[i * 8 + 6] = mesh->mTextureCoords[0][i].x;
-                vertices[i * 8 + 7] = mesh->mTextureCoords[0][i].y;
-            }
-            else
-            {
-                vertices[i * 8 + 6] = 0.0f;
-                vertices[i * 8 + 7] = 0.0f;
-            }
-        }
-        catch (...)
-        {
-            std::cout << "error happened when initialize vertices" << std::endl;
-        }
-    }
-
-    for (int i = 0; i < mesh->mNumFaces; i++)
-    {
-        aiFace face = mesh->mFaces[i];
-        try
-        {
-            indices[i * 3 + 0] = face.mIndices[0];
-            indices[i * 3 + 1] = face.mIndices[1];
-            indices[i * 3 + 2] = face.mIndices[2];
-        }
-        catch (...)
-        {
-            std::cout << "error happened when initialize indices" << std::endl;
-        }
-    }
+    InterleaveVertices(mesh, vertices);
+    CopyFaceIndices(mesh, indices);
 
     if (mesh->mMaterialIndex >= 0)
     {
@@ -83,120 +55,238 @@ Mesh::Mesh(aiMesh *mesh, const aiScene *scence, const std::string &dict)
             textures.push_back(Texture(dict, texfile, TextureType::AMBIENT));
         }
     }
+
+    ComputeBounds();
 }
+Mesh::Mesh(const std::vector<float> &vertexData, const std::vector<unsigned int> &indexData)
+    : vertices(nullptr), indices(nullptr)
+{
+    v_num = (int)vertexData.size() / 8;
+    i_num = (int)indexData.size();
+    v_size = v_num * 8;
+    i_size = i_num;
+    vertices = new float[v_size];
+    indices = new unsigned int[i_size];
+    std::copy(vertexData.begin(), vertexData.begin() + v_size, vertices);
+    std::copy(indexData.begin(), indexData.end(), indices);
+
+    ComputeBounds();
+}
+
 Mesh::~Mesh()
 {
-    if (vertices)
-        delete[] vertices;
-    if (indices)
-        delete[] indices;
-
-    // 释放GPU资源
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-    glDeleteBuffers(1, &ibo);
-    glDeleteBuffers(1, &instanceVBO);
+    if (!mapping)
+    {
+        if (vertices)
+            delete[] vertices;
+        if (indices)
+            delete[] indices;
+    }
+
+    // 归还共享页中的区间（只在CPU侧构建过、没有上传的mesh可能在工作线程析构，此时没有分配，不碰GL）
+    GeometryArena::Instance().Free(geometry);
 }
 
-void Mesh::initialize()
+void Mesh::ComputeBounds()
 {
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, v_size * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, i_size * sizeof(float), indices, GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (const void *)(0 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (const void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (const void *)(6 * sizeof(float)));
+    if (v_num == 0)
+    {
+        boundsMin = boundsMax = boundsCenter = glm::vec3(0.0f);
+        boundsRadius = 0.0f;
+        return;
+    }
+
+    // 大mesh分块并行：每块先算自己的结果，最后在锁内合并
+    std::mutex mergeMutex;
+    boundsMin = glm::vec3(vertices[0], vertices[1], vertices[2]);
+    boundsMax = boundsMin;
+    ParallelFor(0, v_num, BOUNDS_GRAIN, [&](size_t begin, size_t end)
+                {
+                    glm::vec3 chunkMin(vertices[begin * 8 + 0], vertices[begin * 8 + 1], vertices[begin * 8 + 2]);
+                    glm::vec3 chunkMax = chunkMin;
+                    for (size_t i = begin + 1; i < end; i++)
+                    {
+                        glm::vec3 p(vertices[i * 8 + 0], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+                        chunkMin = glm::min(chunkMin, p);
+                        chunkMax = glm::max(chunkMax, p);
+                    }
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    boundsMin = glm::min(boundsMin, chunkMin);
+                    boundsMax = glm::max(boundsMax, chunkMax); });
+
+    // 以包围盒中心为球心，半径取最远的顶点，比半对角线更紧
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    float radiusSq = 0.0f;
+    ParallelFor(0, v_num, BOUNDS_GRAIN, [&](size_t begin, size_t end)
+                {
+                    float chunkRadiusSq = 0.0f;
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        glm::vec3 d = glm::vec3(vertices[i * 8 + 0], vertices[i * 8 + 1], vertices[i * 8 + 2]) - boundsCenter;
+                        chunkRadiusSq = std::max(chunkRadiusSq, glm::dot(d, d));
+                    }
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    radiusSq = std::max(radiusSq, chunkRadiusSq); });
+    boundsRadius = std::sqrt(radiusSq);
 }
-void Mesh::draw(std::shared_ptr<Shader> shader)
+
+// drawRanges的参数数组，只在主线程使用，每次复用保留容量；上传时按簇数预留，绘制时不再增长
+static std::vector<GLsizei> rangeCounts;
+static std::vector<void *> rangeOffsets;
+static std::vector<GLint> rangeBaseVertices;
+
+void Mesh::initialize()
 {
-    unsigned int count = 1;
-    for (int i = 0; i < textures.size(); i++)
+    if (geometry.page)
+        return;
+    if (id == 0)
+        id = NextObjectId<Mesh>();
+    // 可见区间数不超过簇数
+    if (rangeCounts.capacity() < meshlets.size())
     {
-        textures[i].bind(i + 1);
-        if (textures[i].type == TextureType::DIFFUSE)
-        {
-            shader->SetUniform1i(("utexture_diffuse" + std::to_string(count)).c_str(), i + 1);
-            count++;
-        }
+        rangeCounts.reserve(meshlets.size());
+        rangeOffsets.reserve(meshlets.size());
+        rangeBaseVertices.reserve(meshlets.size());
     }
 
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, i_size, GL_UNSIGNED_INT, NULL);
-    glBindVertexArray(0);
+    for (auto &texture : textures)
+    {
+        texture.upload();
+    }
 
-    for (int i = 0; i < textures.size(); i++)
+    // 顶点数不超过65536时用16位索引，显存和带宽减半（索引相对于baseVertex）
+    indexSize = v_num <= 65536 ? 2 : 4;
+    geometry = GeometryArena::Instance().Allocate(vertexFormat, indexSize, v_num, i_size);
+    GeometryPage &page = *geometry.page;
+
+    if (vertexFormat == VertexFormat::Packed16)
+    {
+        std::vector<PackedVertex> packed(v_num);
+        PackVertices(vertices, v_num, boundsMin, boundsMax, packed.data());
+        page.UploadVertices(geometry.baseVertex, packed.data(), v_num);
+    }
+    else
+    {
+        page.UploadVertices(geometry.baseVertex, vertices, v_num);
+    }
+
+    if (indexSize == 2)
+    {
+        std::vector<uint16_t> narrow(indices, indices + i_size);
+        page.UploadIndices(geometry.firstIndex, narrow.data(), i_size);
+    }
+    else
     {
-        textures[i].unbind();
+        page.UploadIndices(geometry.firstIndex, indices, i_size);
     }
 }
 
-void Mesh::drawInstanced(const std::shared_ptr<Shader> &shader,
-                         const std::vector<glm::mat4> &modelMatrices)
+unsigned int Mesh::IndexType() const
 {
-    // 如果未创建 instance buffer，则创建
-    if (instanceVBO == 0)
-    {
-        glGenBuffers(1, &instanceVBO);
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, modelMatrices.size() * sizeof(glm::mat4),
-                     modelMatrices.data(), GL_DYNAMIC_DRAW);
-
-        // 为 mat4 分配 4 个顶点属性位置
-        for (int i = 0; i < 4; i++)
-        {
-            glEnableVertexAttribArray(3 + i);
-            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE,
-                                  sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * i));
-            glVertexAttribDivisor(3 + i, 1);
-        }
+    return indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+MeshLod Mesh::GetLod(int level) const
+{
+    if (lods.empty())
+        return {0, (unsigned int)i_num};
+    return lods[std::clamp(level, 0, (int)lods.size() - 1)];
+}
 
-        glBindVertexArray(0);
+static constexpr uint32_t ID_POSITION_SCALE = Shader::PropertyToID("positionScale");
+static constexpr uint32_t ID_POSITION_OFFSET = Shader::PropertyToID("positionOffset");
+
+void Mesh::PositionDecode(glm::vec3 &scale, glm::vec3 &offset) const
+{
+    if (vertexFormat == VertexFormat::Packed16)
+    {
+        scale = PackedPositionScale(boundsMin, boundsMax);
+        offset = boundsMin;
     }
     else
     {
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        // 查询当前分配的大小
-        GLint currentSize = 0;
-        glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &currentSize);
-        GLsizeiptr requiredSize = modelMatrices.size() * sizeof(glm::mat4);
+        scale = glm::vec3(1.0f);
+        offset = glm::vec3(0.0f);
+    }
+}
 
-        if (requiredSize > currentSize)
-        {
-            // 重新分配（容量不够）
-            glDeleteBuffers(1, &instanceVBO);
-            glGenBuffers(1, &instanceVBO);
-            glBindVertexArray(vao);
-            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-            glBufferData(GL_ARRAY_BUFFER, requiredSize, modelMatrices.data(), GL_DYNAMIC_DRAW);
-
-            for (int i = 0; i < 4; i++)
-            {
-                glEnableVertexAttribArray(3 + i);
-                glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE,
-                                      sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * i));
-                glVertexAttribDivisor(3 + i, 1);
-            }
-
-            glBindVertexArray(0);
-        }
-        else
+void Mesh::applyVertexDecode(const std::shared_ptr<Shader> &shader)
+{
+    glm::vec3 scale, offset;
+    PositionDecode(scale, offset);
+    shader->SetUniformVec3f(ID_POSITION_SCALE, scale.x, scale.y, scale.z);
+    shader->SetUniformVec3f(ID_POSITION_OFFSET, offset.x, offset.y, offset.z);
+}
+
+void Mesh::draw(std::shared_ptr<Shader> shader, int lod)
+{
+    applyVertexDecode(shader);
+
+    bindTextures(shader);
+
+    MeshLod range = GetLod(lod);
+    GLState::Instance().BindVertexArray(geometry.page->vao);
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, IndexType(),
+                             (void *)((size_t)(geometry.firstIndex + range.firstIndex) * indexSize), geometry.baseVertex);
+}
+
+void Mesh::drawRanges(const std::shared_ptr<Shader> &shader, const std::vector<IndexRange> &ranges)
+{
+    if (ranges.empty())
+        return;
+    applyVertexDecode(shader);
+    bindTextures(shader);
+
+    rangeCounts.clear();
+    rangeOffsets.clear();
+    for (const IndexRange &range : ranges)
+    {
+        rangeCounts.push_back((GLsizei)range.indexCount);
+        rangeOffsets.push_back((void *)((size_t)(geometry.firstIndex + range.firstIndex) * indexSize));
+    }
+    rangeBaseVertices.assign(ranges.size(), (GLint)geometry.baseVertex);
+
+    GLState::Instance().BindVertexArray(geometry.page->vao);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, rangeCounts.data(), IndexType(), rangeOffsets.data(),
+                                  (GLsizei)ranges.size(), rangeBaseVertices.data());
+}
+void Mesh::bindTextures(const std::shared_ptr<Shader> &shader)
+{
+    // utexture_diffuse1, utexture_diffuse2, ...
+    static constexpr uint32_t ID_DIFFUSE[] = {
+        Shader::PropertyToID("utexture_diffuse1"), Shader::PropertyToID("utexture_diffuse2"),
+        Shader::PropertyToID("utexture_diffuse3"), Shader::PropertyToID("utexture_diffuse4"),
+        Shader::PropertyToID("utexture_diffuse5"), Shader::PropertyToID("utexture_diffuse6"),
+        Shader::PropertyToID("utexture_diffuse7"), Shader::PropertyToID("utexture_diffuse8")};
+
+    unsigned int count = 0;
+    for (int i = 0; i < textures.size(); i++)
+    {
+        textures[i].bind(i + 1);
+        if (textures[i].type == TextureType::DIFFUSE && count < std::size(ID_DIFFUSE))
         {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, requiredSize, modelMatrices.data());
+            shader->SetUniform1i(ID_DIFFUSE[count], i + 1);
+            count++;
         }
     }
+}
+
+void Mesh::drawInstanced(const std::shared_ptr<Shader> &shader, unsigned int instanceBuffer,
+                         unsigned int baseInstance, unsigned int instanceCount, int lod)
+{
+    GLState::Instance().BindVertexArray(geometry.page->vao);
+    glBindVertexBuffer(INSTANCE_BINDING, instanceBuffer, 0, sizeof(glm::mat4));
+    drawInstances(shader, baseInstance, instanceCount, lod);
+}
+
+void Mesh::drawInstances(const std::shared_ptr<Shader> &shader, unsigned int baseInstance,
+                         unsigned int instanceCount, int lod)
+{
+    applyVertexDecode(shader);
 
-    glBindVertexArray(vao);
-    glDrawElementsInstanced(GL_TRIANGLES, i_size, GL_UNSIGNED_INT, 0, modelMatrices.size());
-    glBindVertexArray(0);
+    MeshLod range = GetLod(lod);
+    GLState::Instance().BindVertexArray(geometry.page->vao);
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, range.indexCount, IndexType(),
+                                                  (void *)((size_t)(geometry.firstIndex + range.firstIndex) * indexSize),
+                                                  instanceCount, geometry.baseVertex, baseInstance);
 }
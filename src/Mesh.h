@@ -7,12 +7,22 @@
 #include <memory>
 #include <glm/glm.hpp>
 #include "Texture.h"
+#include "MappedFile.h"
+#include "VertexFormat.h"
+#include "Meshlet.h"
+#include "ObjectId.h"
+#include "GeometryArena.h"
+
+// LOD级别在indices中的索引范围
+using MeshLod = IndexRange;
 
 // vertices: n * 8
 // pos.x   pos.y   pos.z   nor.x   nor.y   nor.z   tex.u   tex.v
 class Mesh
 {
 public:
+    // 见Renderer的排序键；在主线程initialize()时分配，与导入线程完成的先后无关，未初始化时为0
+    unsigned int id = 0;
     int v_size;
     int i_size;
     int v_num;
@@ -21,17 +31,67 @@ public:
     unsigned int *indices;
     std::vector<Texture> textures;
 
-    unsigned int vao;
-    unsigned int vbo;
-    unsigned int ibo;
-    unsigned int instanceVBO;
+    // 局部空间包围盒和包围球（球心取包围盒中心），构建时计算，用于视锥剔除和LOD选择
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    // 顶点/索引数据来自内存映射的缓存文件时，持有映射保证指针有效，此时不delete[]
+    std::shared_ptr<MappedFile> mapping;
+
+    // 上传到GPU时使用的顶点格式，需要在initialize()之前设置
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    // LOD链，lods[0]为原始网格；所有级别的索引依次拼接在indices中（i_num为总数），共用同一份顶点
+    // 为空时视为只有一级，覆盖全部索引
+    std::vector<MeshLod> lods;
+    // LOD0的簇划分（按firstIndex递增），用于逐簇剔除；为空则整体绘制
+    std::vector<Meshlet> meshlets;
+
+    // 显存中每个索引的字节数，initialize()时根据顶点数选择2（uint16）或4（uint32）
+    int indexSize = 4;
 
-    Mesh() : v_size(0), i_size(0), vertices(nullptr), indices(nullptr), vao(0), vbo(0), ibo(0), instanceVBO(0) {}
+    // 顶点/索引在GeometryArena共享页中的位置，initialize()时分配，绘制时用baseVertex/firstIndex偏移
+    GeometryAllocation geometry;
+
+    // 实例矩阵（属性3~6）使用的顶点缓冲绑定点，0为顶点数据
+    static constexpr unsigned int INSTANCE_BINDING = 3;
+
+    Mesh() : v_size(0), i_size(0), v_num(0), i_num(0), vertices(nullptr), indices(nullptr) {}
+    // 只构建CPU侧数据，不调用GL，可以在工作线程中执行
     Mesh(aiMesh *mesh, const aiScene *scence, const std::string &dict);
+    // 从已交错好的顶点数组构建（例如程序化生成的几何体），vertices大小为 n * 8
+    Mesh(const std::vector<float> &vertices, const std::vector<unsigned int> &indices);
     ~Mesh();
+    // 根据vertices重新计算包围盒和包围球
+    void ComputeBounds();
+    // 上传GPU资源，必须在主线程调用
     void initialize();
-    void draw(std::shared_ptr<Shader> shader);
+    // 当前顶点格式下显存中每个顶点的字节数
+    int VertexStride() const { return ::VertexStride(vertexFormat); }
+    // 显存占用（字节）
+    size_t GpuVertexBytes() const { return (size_t)v_num * VertexStride(); }
+    size_t GpuIndexBytes() const { return (size_t)i_num * indexSize; }
+    // 对应indexSize的GL类型（GL_UNSIGNED_SHORT/GL_UNSIGNED_INT）
+    unsigned int IndexType() const;
+    // 顶点位置解码参数：position = offset + aPos * scale，Float32格式时为(1, 0)
+    void PositionDecode(glm::vec3 &scale, glm::vec3 &offset) const;
+    int LodCount() const { return lods.empty() ? 1 : (int)lods.size(); }
+    // 越界的level会被截断到最后一级
+    MeshLod GetLod(int level) const;
+    void draw(std::shared_ptr<Shader> shader, int lod = 0);
+
+    // 实例矩阵从instanceBuffer的第baseInstance个mat4开始读取（见InstanceRingBuffer）
+    void drawInstanced(const std::shared_ptr<Shader> &shader, unsigned int instanceBuffer,
+                       unsigned int baseInstance, unsigned int instanceCount, int lod = 0);
+    // 不绑定实例属性，逐实例数据由着色器按gl_BaseInstance + gl_InstanceID从SSBO读取
+    void drawInstances(const std::shared_ptr<Shader> &shader, unsigned int baseInstance, unsigned int instanceCount,
+                       int lod = 0);
+    // 一次提交多个索引区间（glMultiDrawElementsBaseVertex），ranges相对于本mesh的indices，见CullMeshlets
+    void drawRanges(const std::shared_ptr<Shader> &shader, const std::vector<IndexRange> &ranges);
 
-    void drawInstanced(const std::shared_ptr<Shader> &shader,
-                       const std::vector<glm::mat4> &modelMatrices);
+private:
+    // 设置顶点位置解码参数（positionScale/positionOffset）
+    void applyVertexDecode(const std::shared_ptr<Shader> &shader);
+    void bindTextures(const std::shared_ptr<Shader> &shader);
 };
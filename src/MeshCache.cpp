@@ -0,0 +1,383 @@
+#include "MeshCache.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <format>
+#include <cstring>
+
+#include "Model.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+static constexpr char CACHE_MAGIC[8] = {'S', 'V', 'M', 'E', 'S', 'H', 0, 0};
+static constexpr uint32_t CACHE_VERSION = 5;
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t meshCount;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t contentHash;
+    uint32_t boneCount;
+    uint32_t flags; // CACHE_FLAG_*
+};
+
+static constexpr uint32_t CACHE_FLAG_OPTIMIZED = 1 << 0; // 索引/顶点经过MeshOptimizer重排
+static constexpr uint32_t CACHE_FLAG_LODS = 1 << 1;      // 生成了LOD链
+static constexpr uint32_t CACHE_FLAG_MESHLETS = 1 << 2;  // 划分了簇
+
+static uint32_t ModelCacheFlags(const Model &model)
+{
+    return (model.optimizeMesh ? CACHE_FLAG_OPTIMIZED : 0) | (model.generateLods ? CACHE_FLAG_LODS : 0) |
+           (model.buildMeshlets ? CACHE_FLAG_MESHLETS : 0);
+}
+
+struct CacheMeshRecord
+{
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t textureCount;
+    uint32_t lodCount;     // 纹理之后紧跟lodCount个MeshLod
+    uint32_t meshletCount; // 再之后是meshletCount个Meshlet
+    float boundsRadius;    // 包围球半径，球心为包围盒中心
+};
+
+// 顺序读取映射内存，越界时标记失败
+struct CacheReader
+{
+    const unsigned char *data;
+    size_t size;
+    size_t offset = 0;
+    bool ok = true;
+
+    const void *Read(size_t bytes)
+    {
+        if (!ok || offset + bytes > size)
+        {
+            ok = false;
+            return nullptr;
+        }
+        const void *ptr = data + offset;
+        offset += bytes;
+        return ptr;
+    }
+
+    template <typename T>
+    T Get()
+    {
+        T value{};
+        if (const void *ptr = Read(sizeof(T)))
+            std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    std::string GetString()
+    {
+        uint32_t length = Get<uint32_t>();
+        const char *ptr = (const char *)Read(length);
+        return ptr ? std::string(ptr, length) : std::string();
+    }
+
+    void Align(size_t alignment)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+    }
+};
+
+struct CacheWriter
+{
+    std::ofstream &out;
+    size_t offset = 0;
+
+    void Write(const void *data, size_t bytes)
+    {
+        out.write((const char *)data, bytes);
+        offset += bytes;
+    }
+
+    template <typename T>
+    void Put(const T &value)
+    {
+        Write(&value, sizeof(T));
+    }
+
+    void PutString(const std::string &s)
+    {
+        Put<uint32_t>((uint32_t)s.size());
+        Write(s.data(), s.size());
+    }
+
+    void Align(size_t alignment)
+    {
+        static const char zeros[16] = {};
+        size_t padding = (alignment - offset % alignment) % alignment;
+        Write(zeros, padding);
+    }
+};
+
+static bool StatSource(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec)
+        return false;
+    mtime = (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+static bool HashSource(const std::string &path, uint64_t &hash)
+{
+    MappedFile source;
+    if (!source.Open(path))
+        return false;
+    hash = MeshCache::HashBytes(source.Data(), source.Size());
+    return true;
+}
+
+uint64_t MeshCache::HashBytes(const void *data, size_t size, uint64_t seed)
+{
+    // FNV-1a
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string MeshCache::CacheDirectory()
+{
+    return Path(ROOT_DIR) + "cache";
+}
+
+std::string MeshCache::CachePath(const std::string &sourcePath)
+{
+    std::string absPath = fs::absolute(sourcePath).generic_string();
+    return Path(CacheDirectory()) + std::format("{:016x}.svmesh", HashBytes(absPath.data(), absPath.size()));
+}
+
+bool MeshCache::Load(const std::string &sourcePath, Model &model)
+{
+    std::string cachePath = CachePath(sourcePath);
+    auto mapping = std::make_shared<MappedFile>();
+    if (!mapping->Open(cachePath))
+        return false;
+
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    if (!StatSource(sourcePath, sourceSize, sourceMtime))
+        return false;
+
+    CacheReader reader{mapping->Data(), mapping->Size()};
+    CacheHeader header = reader.Get<CacheHeader>();
+    if (!reader.ok || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION)
+        return false;
+    if (reader.GetString() != fs::absolute(sourcePath).generic_string())
+        return false;
+    if (header.sourceSize != sourceSize)
+        return false;
+    if (header.flags != ModelCacheFlags(model))
+        return false;
+
+    bool refreshHeader = false;
+    if (header.sourceMtime != sourceMtime)
+    {
+        // 文件被touch过，但内容可能没变
+        uint64_t contentHash;
+        if (!HashSource(sourcePath, contentHash) || contentHash != header.contentHash)
+            return false;
+        refreshHeader = true;
+    }
+
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::string> meshKeys;
+    meshes.reserve(header.meshCount);
+    for (uint32_t m = 0; m < header.meshCount && reader.ok; m++)
+    {
+        CacheMeshRecord record = reader.Get<CacheMeshRecord>();
+
+        auto mesh = std::make_shared<Mesh>();
+        mesh->mapping = mapping;
+        mesh->v_num = (int)record.vertexCount;
+        mesh->i_num = (int)record.indexCount;
+        mesh->v_size = mesh->v_num * 8;
+        mesh->i_size = mesh->i_num;
+        mesh->boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+        mesh->boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+        mesh->boundsCenter = (mesh->boundsMin + mesh->boundsMax) * 0.5f;
+        mesh->boundsRadius = record.boundsRadius;
+
+        for (uint32_t t = 0; t < record.textureCount && reader.ok; t++)
+        {
+            TextureType type = (TextureType)reader.Get<uint32_t>();
+            std::string dict = reader.GetString();
+            std::string file = reader.GetString();
+            if (reader.ok)
+                mesh->textures.push_back(Texture(dict, file, type));
+        }
+        for (uint32_t l = 0; l < record.lodCount && reader.ok; l++)
+        {
+            MeshLod lod = reader.Get<MeshLod>();
+            if (lod.firstIndex + (uint64_t)lod.indexCount > record.indexCount)
+                reader.ok = false;
+            mesh->lods.push_back(lod);
+        }
+        mesh->meshlets.reserve(record.meshletCount);
+        for (uint32_t c = 0; c < record.meshletCount && reader.ok; c++)
+        {
+            Meshlet meshlet = reader.Get<Meshlet>();
+            if (meshlet.firstIndex + (uint64_t)meshlet.indexCount > record.indexCount)
+                reader.ok = false;
+            mesh->meshlets.push_back(meshlet);
+        }
+
+        reader.Align(16);
+        mesh->vertices = (float *)reader.Read((size_t)mesh->v_size * sizeof(float));
+        reader.Align(16);
+        mesh->indices = (unsigned int *)reader.Read((size_t)mesh->i_size * sizeof(unsigned int));
+
+        meshKeys.push_back(std::format("{}/{}_{}", std::string(model.directory), model.filename, m));
+        meshes.push_back(mesh);
+    }
+
+    std::unordered_map<std::string, std::tuple<Vector3, Vector3, std::string>> bones;
+    for (uint32_t b = 0; b < header.boneCount && reader.ok; b++)
+    {
+        std::string name = reader.GetString();
+        Vector3 head = reader.Get<Vector3>();
+        Vector3 tail = reader.Get<Vector3>();
+        std::string parent = reader.GetString();
+        bones[name] = {head, tail, parent};
+    }
+
+    if (!reader.ok)
+    {
+        std::cout << "[MeshCache] corrupted cache file: " << cachePath << std::endl;
+        return false;
+    }
+
+    if (refreshHeader)
+    {
+        // 缓存文件仍在映射中（网格数据指向它），只原地改写文件头
+        header.sourceMtime = sourceMtime;
+        std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        file.write((const char *)&header, sizeof(header));
+        if (!file.good())
+            std::cout << "[MeshCache] failed to refresh header, source will be re-hashed next load: " << cachePath << std::endl;
+    }
+
+    model.meshes = std::move(meshes);
+    model.meshKeys = std::move(meshKeys);
+    for (auto &[name, bone] : bones)
+    {
+        model.bones[name] = bone;
+    }
+    std::cout << "[MeshCache] hit: " << sourcePath << std::endl;
+    return true;
+}
+
+bool MeshCache::Store(const std::string &sourcePath, const Model &model)
+{
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.meshCount = (uint32_t)model.meshes.size();
+    header.boneCount = (uint32_t)model.bones.size();
+    header.flags = ModelCacheFlags(model);
+    if (!StatSource(sourcePath, header.sourceSize, header.sourceMtime) || !HashSource(sourcePath, header.contentHash))
+        return false;
+
+    std::error_code ec;
+    fs::create_directories(CacheDirectory(), ec);
+    if (ec)
+        return false;
+
+    // 先写临时文件再替换，避免留下写了一半的缓存
+    std::string cachePath = CachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+
+        CacheWriter writer{out};
+        writer.Put(header);
+        writer.PutString(fs::absolute(sourcePath).generic_string());
+
+        for (auto &mesh : model.meshes)
+        {
+            CacheMeshRecord record{};
+            record.vertexCount = (uint32_t)mesh->v_num;
+            record.indexCount = (uint32_t)mesh->i_num;
+            std::memcpy(record.boundsMin, &mesh->boundsMin, sizeof(record.boundsMin));
+            std::memcpy(record.boundsMax, &mesh->boundsMax, sizeof(record.boundsMax));
+            record.boundsRadius = mesh->boundsRadius;
+            record.textureCount = (uint32_t)mesh->textures.size();
+            record.lodCount = (uint32_t)mesh->lods.size();
+            record.meshletCount = (uint32_t)mesh->meshlets.size();
+            writer.Put(record);
+
+            for (auto &texture : mesh->textures)
+            {
+                writer.Put<uint32_t>((uint32_t)texture.type);
+                writer.PutString(texture.dict);
+                writer.PutString(texture.file);
+            }
+            for (auto &lod : mesh->lods)
+            {
+                writer.Put(lod);
+            }
+            writer.Write(mesh->meshlets.data(), mesh->meshlets.size() * sizeof(Meshlet));
+
+            writer.Align(16);
+            writer.Write(mesh->vertices, (size_t)mesh->v_size * sizeof(float));
+            writer.Align(16);
+            writer.Write(mesh->indices, (size_t)mesh->i_size * sizeof(unsigned int));
+        }
+
+        for (auto &[name, bone] : model.bones)
+        {
+            auto &[head, tail, parent] = bone;
+            writer.PutString(name);
+            writer.Put(head);
+            writer.Put(tail);
+            writer.PutString(parent);
+        }
+
+        if (!out.good())
+            return false;
+    }
+
+    fs::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        // Windows上旧缓存仍被已加载的网格映射时不能被覆盖，但可以改名：先移开再替换
+        std::string stalePath = cachePath + ".stale";
+        std::error_code removeError;
+        fs::remove(stalePath, removeError);
+        ec.clear();
+        fs::rename(cachePath, stalePath, ec);
+        if (!ec)
+        {
+            fs::rename(tempPath, cachePath, ec);
+            if (ec)
+                fs::rename(stalePath, cachePath, removeError);
+        }
+        if (ec)
+        {
+            std::cout << "[MeshCache] failed to replace cache file " << cachePath << ": " << ec.message() << std::endl;
+            fs::remove(tempPath, removeError);
+            return false;
+        }
+        // 仍被映射时删除失败，留到下次替换时再删
+        fs::remove(stalePath, removeError);
+    }
+    return true;
+}
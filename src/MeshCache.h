@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+class Model;
+
+// 导入结果的二进制缓存
+// 保存Assimp导入并交错后的顶点/索引数组、每个mesh的包围盒以及骨骼表，
+// 重新打开同一个模型时直接内存映射缓存文件，顶点数据不经拷贝直接交给glBufferData
+//
+// 缓存以源文件路径命名，文件头记录源文件的大小、修改时间和内容哈希：
+//   大小和修改时间都一致 -> 直接命中
+//   只有修改时间变化     -> 重新计算内容哈希，一致则仍然命中并刷新文件头
+//   其余情况             -> 失效，重新导入后覆盖
+// 是否经过MeshOptimizer、是否划分簇/生成LOD也记录在文件头中，与Model上对应的开关不一致时同样视为失效
+class MeshCache
+{
+public:
+    // 命中时填充model的meshes/meshKeys/bones并返回true
+    static bool Load(const std::string &sourcePath, Model &model);
+    // 把model当前的导入结果写入缓存
+    static bool Store(const std::string &sourcePath, const Model &model);
+
+    // 缓存文件所在目录及路径
+    static std::string CacheDirectory();
+    static std::string CachePath(const std::string &sourcePath);
+
+    static uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ull);
+};
@@ -1,6 +1,7 @@
 #include "MeshManager.h"
 #include <iostream>
 #include <filesystem>
+#include <iomanip>
 
 std::shared_ptr<Mesh> MeshManager::LoadMesh(const std::string &path, const std::string &dict)
 {
@@ -36,6 +37,17 @@ std::shared_ptr<Mesh> MeshManager::LoadMesh(aiMesh *mesh, const aiScene *scene,
     return newMesh;
 }
 
+std::shared_ptr<Mesh> MeshManager::AddMesh(const std::string &key, const std::shared_ptr<Mesh> &mesh)
+{
+    auto it = meshCache.find(key);
+    if (it != meshCache.end())
+        return it->second;
+
+    mesh->initialize();
+    meshCache[key] = mesh;
+    return mesh;
+}
+
 std::shared_ptr<Mesh> MeshManager::Get(const std::string &key)
 {
     auto it = meshCache.find(key);
@@ -142,6 +154,8 @@ void MeshManager::Clear()
 void MeshManager::PrintStatus() const
 {
     std::cout << "[MeshManager] Loaded meshes: " << meshCache.size() << std::endl;
+    size_t vertexBytes = 0, indexBytes = 0;
+    size_t fullVertexBytes = 0, fullIndexBytes = 0; // 全部使用float32顶点和uint32索引时的占用
     for (auto &[key, val] : meshCache)
     {
         int lastUsedFrame;
@@ -153,6 +167,21 @@ void MeshManager::PrintStatus() const
         {
             lastUsedFrame = -1;
         }
-        std::cout << " - " << key << " (use_count=" << val.use_count() << ")" << " LastUsed: " << lastUsedFrame << std::endl;
+        std::cout << " - " << key << " (use_count=" << val.use_count() << ")" << " LastUsed: " << lastUsedFrame
+                  << " VBO: " << val->GpuVertexBytes() / 1024 << "KB IBO: " << val->GpuIndexBytes() / 1024 << "KB (uint" << val->indexSize * 8 << ") LODs: " << val->LodCount() << std::endl;
+
+        vertexBytes += val->GpuVertexBytes();
+        indexBytes += val->GpuIndexBytes();
+        fullVertexBytes += (size_t)val->v_num * 8 * sizeof(float);
+        fullIndexBytes += (size_t)val->i_num * sizeof(unsigned int);
     }
+
+    auto mb = [](size_t bytes)
+    { return bytes / (1024.0 * 1024.0); };
+    std::cout << std::fixed << std::setprecision(2)
+              << "[MeshManager] GPU memory: vertices " << mb(vertexBytes) << "MB (float32: " << mb(fullVertexBytes) << "MB), "
+              << "indices " << mb(indexBytes) << "MB (uint32: " << mb(fullIndexBytes) << "MB), "
+              << "saved " << mb(fullVertexBytes + fullIndexBytes - vertexBytes - indexBytes) << "MB"
+              << std::defaultfloat << std::endl;
+    std::cout << "[MeshManager] Geometry pages: " << GeometryArena::Instance().PageCount() << std::endl;
 }
@@ -25,6 +25,10 @@ public:
     // 从Assimp直接加载
     std::shared_ptr<Mesh> LoadMesh(aiMesh *mesh, const aiScene *scene, const std::string &dict);
 
+    // 注册一个已在CPU侧构建好的Mesh（例如工作线程导入的），并上传到GPU
+    // 如果key已存在，返回已缓存的mesh
+    std::shared_ptr<Mesh> AddMesh(const std::string &key, const std::shared_ptr<Mesh> &mesh);
+
     // 根据唯一key（例如path或hash）获取已存在mesh
     std::shared_ptr<Mesh> Get(const std::string &key);
 
@@ -43,7 +47,7 @@ public:
 
         for (auto it = meshCache.begin(); it != meshCache.end();)
         {
-            const std::string key = it->first;
+            const std::string &key = it->first;
             std::shared_ptr<Mesh> &mesh = it->second;
 
             // 检查是否长时间未使用且引用计数为1（只有cache持有）
@@ -52,8 +56,9 @@ public:
                 if (currentFrame - meshLastUsedFrame[key] > keepFrames)
                 {
                     std::cout << "Cleaning up unused mesh: " << key << std::endl;
-                    it = meshCache.erase(it);
+                    // key引用的是meshCache中的字符串，先删meshLastUsedFrame
                     meshLastUsedFrame.erase(key);
+                    it = meshCache.erase(it);
                 }
                 else
                 {
@@ -0,0 +1,286 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+float ComputeACMR(const unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    if (indexCount < 3)
+        return 0.0f;
+
+    // cacheTime[v]记录v进入缓存时的时间戳，时间戳差大于cacheSize即已被挤出
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int v = indices[i];
+        if (timestamp - cacheTime[v] > cacheSize)
+        {
+            cacheTime[v] = timestamp++;
+            misses++;
+        }
+    }
+    return (float)misses / (float)(indexCount / 3);
+}
+
+void OptimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // 顶点 -> 三角形的邻接表（CSR）
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        liveTriangles[indices[i]]++;
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    deadEnd.reserve(triangleCount * 3);
+
+    unsigned int timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    long long fanning = 0;
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        for (unsigned int a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+        {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timestamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timestamp++;
+            }
+            emitted[t] = 1;
+        }
+
+        // 在刚输出的顶点中选下一个扇形中心：仍在缓存中且剩余三角形能放得下的优先
+        long long best = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+            int priority = 0;
+            if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = (int)(timestamp - cacheTime[v]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        if (best == -1)
+        {
+            // 走到死角：先从最近输出的顶点里找，再按顺序找还有三角形的顶点
+            while (!deadEnd.empty())
+            {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0)
+                {
+                    best = v;
+                    break;
+                }
+            }
+            while (best == -1 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                    best = (long long)cursor;
+                cursor++;
+            }
+        }
+        fanning = best;
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void OptimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount,
+                      unsigned int cacheSize, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // 1. 三个顶点全部缓存未命中的位置是天然的簇边界
+    std::vector<size_t> clusters;
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (timestamp - cacheTime[v] > cacheSize)
+            {
+                cacheTime[v] = timestamp++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+            clusters.push_back(t);
+    }
+    clusters.push_back(triangleCount);
+
+    // 2. 在不让ACMR恶化超过threshold的前提下把大簇继续切小，排序的粒度更细
+    float acmr = ComputeACMR(indices, indexCount, vertexCount, cacheSize);
+    std::vector<size_t> softClusters;
+    for (size_t c = 0; c + 1 < clusters.size(); c++)
+    {
+        size_t start = clusters[c];
+        size_t end = clusters[c + 1];
+        softClusters.push_back(start);
+
+        // 时间戳前移超过缓存大小即相当于清空缓存，不需要重新填充cacheTime
+        timestamp += cacheSize + 1;
+        size_t misses = 0;
+        for (size_t t = start; t < end; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (timestamp - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = timestamp++;
+                    misses++;
+                }
+            }
+            size_t count = t - start + 1;
+            if (t + 1 < end && count >= 8 && (float)misses / count <= acmr * threshold)
+            {
+                softClusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                timestamp += cacheSize + 1;
+            }
+        }
+    }
+    softClusters.push_back(triangleCount);
+
+    // 3. 每个簇的面积加权法线与质心，按 dot(质心 - 网格中心, 法线) 从大到小排序
+    auto position = [&](unsigned int v)
+    {
+        return glm::vec3(vertices[v * 8 + 0], vertices[v * 8 + 1], vertices[v * 8 + 2]);
+    };
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    size_t clusterCount = softClusters.size() - 1;
+    std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float clusterArea = 0.0f;
+        for (size_t t = softClusters[c]; t < softClusters[c + 1]; t++)
+        {
+            glm::vec3 a = position(indices[t * 3 + 0]);
+            glm::vec3 b = position(indices[t * 3 + 1]);
+            glm::vec3 d = position(indices[t * 3 + 2]);
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float area = glm::length(n);
+            glm::vec3 centroid = (a + b + d) / 3.0f;
+            clusterCentroid[c] += centroid * area;
+            clusterNormal[c] += n;
+            clusterArea += area;
+        }
+        meshCentroid += clusterCentroid[c];
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f)
+            clusterCentroid[c] /= clusterArea;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float len = glm::length(clusterNormal[c]);
+        glm::vec3 n = len > 0.0f ? clusterNormal[c] / len : glm::vec3(0.0f);
+        sortKey[c] = glm::dot(clusterCentroid[c] - meshCentroid, n);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     { return sortKey[a] > sortKey[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    for (size_t c : order)
+    {
+        result.insert(result.end(), indices + softClusters[c] * 3, indices + softClusters[c + 1] * 3);
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void OptimizeVertexFetch(float *vertices, size_t vertexCount, unsigned int *indices, size_t indexCount)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    unsigned int next = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int &target = remap[indices[i]];
+        if (target == unused)
+            target = next++;
+        indices[i] = target;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] == unused)
+            remap[v] = next++;
+    }
+
+    std::vector<float> reordered(vertexCount * 8);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        std::copy(vertices + v * 8, vertices + v * 8 + 8, reordered.begin() + remap[v] * 8);
+    }
+    std::copy(reordered.begin(), reordered.end(), vertices);
+}
+
+MeshOptimizeStats OptimizeMesh(Mesh &mesh)
+{
+    MeshOptimizeStats stats;
+    size_t indexCount = (size_t)mesh.i_num;
+    size_t vertexCount = (size_t)mesh.v_num;
+    stats.acmrBefore = ComputeACMR(mesh.indices, indexCount, vertexCount);
+
+    OptimizeVertexCache(mesh.indices, indexCount, vertexCount);
+    OptimizeOverdraw(mesh.indices, indexCount, mesh.vertices, vertexCount);
+    OptimizeVertexFetch(mesh.vertices, vertexCount, mesh.indices, indexCount);
+
+    stats.acmrAfter = ComputeACMR(mesh.indices, indexCount, vertexCount);
+    return stats;
+}
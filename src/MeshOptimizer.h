@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+
+class Mesh;
+
+// 导入后的索引/顶点重排，只修改CPU侧数据，需在Mesh::initialize()之前调用
+
+// 模拟FIFO顶点缓存，返回平均每个三角形的缓存未命中数（ACMR，越低越好，理想值约0.5）
+float ComputeACMR(const unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+// Tipsify (Sander et al. 2007)：重排三角形提高后变换顶点缓存命中率
+void OptimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+// 在缓存优化的结果上按簇排序，让朝外的簇先画，减少overdraw
+// vertices为8个float交错格式，threshold为允许的ACMR恶化比例
+void OptimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount,
+                      unsigned int cacheSize = 16, float threshold = 1.05f);
+
+// 按首次使用顺序重排顶点，提高顶点拉取的局部性；未被引用的顶点放到最后
+void OptimizeVertexFetch(float *vertices, size_t vertexCount, unsigned int *indices, size_t indexCount);
+
+struct MeshOptimizeStats
+{
+    float acmrBefore = 0.0f;
+    float acmrAfter = 0.0f;
+};
+
+// 依次执行以上三步
+MeshOptimizeStats OptimizeMesh(Mesh &mesh);
@@ -0,0 +1,312 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+    // 对称4x4矩阵，只存上三角
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+
+        void AddPlane(const glm::dvec3 &n, double d, double weight)
+        {
+            a00 += weight * n.x * n.x;
+            a01 += weight * n.x * n.y;
+            a02 += weight * n.x * n.z;
+            a03 += weight * n.x * d;
+            a11 += weight * n.y * n.y;
+            a12 += weight * n.y * n.z;
+            a13 += weight * n.y * d;
+            a22 += weight * n.z * n.z;
+            a23 += weight * n.z * d;
+            a33 += weight * d * d;
+        }
+
+        void Add(const Quadric &q)
+        {
+            a00 += q.a00, a01 += q.a01, a02 += q.a02, a03 += q.a03;
+            a11 += q.a11, a12 += q.a12, a13 += q.a13;
+            a22 += q.a22, a23 += q.a23;
+            a33 += q.a33;
+        }
+
+        double Error(const glm::dvec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double e = a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+                       2.0 * (a01 * x * y + a02 * x * z + a03 * x + a12 * y * z + a13 * y + a23 * z);
+            return std::max(e, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        float cost;
+        unsigned int from;
+        unsigned int to;
+    };
+
+    // 一个顶点的全部属性（位置、法线、UV），按位比较
+    struct VertexKey
+    {
+        float values[8];
+
+        bool operator==(const VertexKey &other) const { return std::memcmp(values, other.values, sizeof(values)) == 0; }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &key) const noexcept
+        {
+            unsigned int bits[8];
+            std::memcpy(bits, key.values, sizeof(bits));
+            size_t hash = 0;
+            for (unsigned int b : bits)
+                hash = hash * 31 + b * 2654435761u;
+            return hash;
+        }
+    };
+}
+
+size_t SimplifyMesh(const float *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                    size_t targetIndexCount, unsigned int *dst)
+{
+    auto position = [&](unsigned int v)
+    {
+        return glm::dvec3(vertices[v * 8 + 0], vertices[v * 8 + 1], vertices[v * 8 + 2]);
+    };
+
+    // 1. 焊接属性完全相同的重复顶点；UV/法线接缝两侧属性不同，不焊接，
+    //    接缝边因此成为开放边界，在第3步被锁定，简化后接缝不会撕开
+    std::vector<unsigned int> weld(vertexCount);
+    {
+        std::unordered_map<VertexKey, unsigned int, VertexKeyHash> firstWithAttributes;
+        firstWithAttributes.reserve(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            VertexKey key;
+            std::memcpy(key.values, vertices + v * 8, sizeof(key.values));
+            weld[v] = firstWithAttributes.emplace(key, (unsigned int)v).first->second;
+        }
+    }
+
+    std::vector<unsigned int> triangles;
+    triangles.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned int a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+        if (a != b && b != c && c != a)
+            triangles.insert(triangles.end(), {a, b, c});
+    }
+
+    // 2. 每个顶点的误差二次型：相邻三角形平面按面积加权
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        glm::dvec3 p0 = position(triangles[i]), p1 = position(triangles[i + 1]), p2 = position(triangles[i + 2]);
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(n);
+        if (area <= 0.0)
+            continue;
+        n /= area;
+        double d = -glm::dot(n, p0);
+        for (int k = 0; k < 3; k++)
+            quadrics[triangles[i + k]].AddPlane(n, d, area * 0.5);
+    }
+
+    // 3. 只被一个三角形使用的边是开放边界（包括属性接缝），锁定其顶点以保持轮廓
+    std::vector<char> locked(vertexCount, 0);
+    {
+        std::vector<unsigned long long> edges;
+        edges.reserve(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned long long a = triangles[i + k], b = triangles[i + (k + 1) % 3];
+                edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();)
+        {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                j++;
+            if (j - i == 1)
+            {
+                locked[edges[i] >> 32] = 1;
+                locked[edges[i] & 0xffffffffull] = 1;
+            }
+            i = j;
+        }
+    }
+
+    // 4. 分轮折叠：每轮按代价从小到大选一批互不影响的边
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> collapseTarget(vertexCount);
+    std::vector<char> touched(vertexCount);
+
+    while (triangles.size() > targetIndexCount)
+    {
+        // 顶点 -> 三角形邻接（CSR）
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (unsigned int v : triangles)
+            adjacencyOffsets[v + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(triangles.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < triangles.size(); i++)
+                adjacency[fill[triangles[i]]++] = (unsigned int)(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = triangles[i + k], b = triangles[i + (k + 1) % 3];
+                // 每条内部边会被两个三角形各访问一次，只在a<b时处理
+                if (a > b)
+                    continue;
+                double costAB = locked[a] ? -1.0 : quadrics[a].Error(position(b)) + quadrics[b].Error(position(b));
+                double costBA = locked[b] ? -1.0 : quadrics[a].Error(position(a)) + quadrics[b].Error(position(a));
+                if (costAB < 0.0 && costBA < 0.0)
+                    continue;
+                if (costBA < 0.0 || (costAB >= 0.0 && costAB <= costBA))
+                    collapses.push_back({(float)costAB, a, b});
+                else
+                    collapses.push_back({(float)costBA, b, a});
+            }
+        }
+        if (collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y)
+                  { return x.cost < y.cost; });
+
+        for (size_t v = 0; v < vertexCount; v++)
+            collapseTarget[v] = (unsigned int)v;
+        std::fill(touched.begin(), touched.end(), 0);
+
+        size_t trianglesToRemove = (triangles.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t performed = 0;
+        for (const Collapse &c : collapses)
+        {
+            if (removed >= trianglesToRemove)
+                break;
+            if (touched[c.from] || touched[c.to])
+                continue;
+
+            // 检查折叠后相邻三角形是否翻面
+            bool flips = false;
+            size_t shared = 0;
+            glm::dvec3 target = position(c.to);
+            for (unsigned int a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1] && !flips; a++)
+            {
+                const unsigned int *tri = &triangles[adjacency[a] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                {
+                    shared++;
+                    continue;
+                }
+                glm::dvec3 p[3], q[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = position(tri[k]);
+                    q[k] = tri[k] == c.from ? target : p[k];
+                }
+                glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::dvec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                if (glm::dot(before, after) <= 0.0)
+                    flips = true;
+            }
+            if (flips)
+                continue;
+
+            collapseTarget[c.from] = c.to;
+            // 相邻三角形的所有顶点本轮不再参与折叠，保证翻面检查有效
+            for (unsigned int a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; a++)
+            {
+                const unsigned int *tri = &triangles[adjacency[a] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            quadrics[c.to].Add(quadrics[c.from]);
+            removed += shared;
+            performed++;
+        }
+        if (performed == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int a = collapseTarget[triangles[i]];
+            unsigned int b = collapseTarget[triangles[i + 1]];
+            unsigned int c = collapseTarget[triangles[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+        triangles.resize(write);
+    }
+
+    std::copy(triangles.begin(), triangles.end(), dst);
+    return triangles.size();
+}
+
+void GenerateLods(Mesh &mesh, int maxLevels, size_t minTriangles)
+{
+    size_t baseCount = (size_t)mesh.i_num;
+    mesh.lods.clear();
+    mesh.lods.push_back({0, (unsigned int)baseCount});
+    if (baseCount / 3 < minTriangles || maxLevels <= 1)
+        return;
+
+    std::vector<unsigned int> all(mesh.indices, mesh.indices + baseCount);
+    std::vector<unsigned int> level(baseCount);
+    size_t previousCount = baseCount;
+    for (int l = 1; l < maxLevels; l++)
+    {
+        size_t target = previousCount / 2 / 3 * 3;
+        const unsigned int *source = all.data() + mesh.lods.back().firstIndex;
+        size_t count = SimplifyMesh(mesh.vertices, (size_t)mesh.v_num, source, previousCount, target, level.data());
+        // 简化不动了（例如大部分是边界）就停止
+        if (count == 0 || count > previousCount * 9 / 10)
+            break;
+
+        OptimizeVertexCache(level.data(), count, (size_t)mesh.v_num);
+        mesh.lods.push_back({(unsigned int)all.size(), (unsigned int)count});
+        all.insert(all.end(), level.begin(), level.begin() + count);
+        previousCount = count;
+        if (count / 3 < minTriangles / 4)
+            break;
+    }
+
+    if (mesh.lods.size() == 1)
+        return;
+
+    unsigned int *indices = new unsigned int[all.size()];
+    std::copy(all.begin(), all.end(), indices);
+    if (!mesh.mapping)
+        delete[] mesh.indices;
+    mesh.indices = indices;
+    mesh.i_num = (int)all.size();
+    mesh.i_size = mesh.i_num;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class Mesh;
+
+// 二次误差度量(QEM)的边折叠简化，只生成新的索引，顶点缓冲保持不变
+// 属性完全相同的顶点视为同一个顶点；开放边界和UV/法线接缝上的顶点不会被折叠
+// vertices为8个float交错格式，返回写入dst的索引数（dst至少能容纳indexCount个索引）
+size_t SimplifyMesh(const float *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                    size_t targetIndexCount, unsigned int *dst);
+
+// 为mesh生成LOD链（每级三角形约为上一级的一半，最多maxLevels级，包含原始级别）
+// 各级索引依次拼接存放在mesh.indices中，见Mesh::lods
+void GenerateLods(Mesh &mesh, int maxLevels = 5, size_t minTriangles = 4096);
@@ -0,0 +1,191 @@
+#include "Meshlet.h"
+#include "FrustumCull.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static void ComputeMeshletBounds(Meshlet &meshlet, const unsigned int *indices, const float *vertices)
+{
+    auto position = [&](unsigned int v)
+    {
+        return glm::vec3(vertices[v * 8 + 0], vertices[v * 8 + 1], vertices[v * 8 + 2]);
+    };
+
+    glm::vec3 minP(std::numeric_limits<float>::max()), maxP(-std::numeric_limits<float>::max());
+    glm::vec3 normalSum(0.0f);
+    const unsigned int *tri = indices + meshlet.firstIndex;
+    for (unsigned int i = 0; i < meshlet.indexCount; i += 3)
+    {
+        glm::vec3 p0 = position(tri[i]), p1 = position(tri[i + 1]), p2 = position(tri[i + 2]);
+        minP = glm::min(minP, glm::min(p0, glm::min(p1, p2)));
+        maxP = glm::max(maxP, glm::max(p0, glm::max(p1, p2)));
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(n);
+        if (length > 0.0f)
+            normalSum += n / length;
+    }
+
+    meshlet.center = (minP + maxP) * 0.5f;
+    float radius2 = 0.0f;
+    for (unsigned int i = 0; i < meshlet.indexCount; i++)
+    {
+        glm::vec3 d = position(tri[i]) - meshlet.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    // 法线锥：轴取平均法线，张角由与轴夹角最大的三角形法线决定
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 1.0f;
+    float axisLength = glm::length(normalSum);
+    if (axisLength <= 0.0f)
+        return;
+    glm::vec3 axis = normalSum / axisLength;
+    float minDot = 1.0f;
+    for (unsigned int i = 0; i < meshlet.indexCount; i += 3)
+    {
+        glm::vec3 p0 = position(tri[i]), p1 = position(tri[i + 1]), p2 = position(tri[i + 2]);
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(n);
+        if (length > 0.0f)
+            minDot = std::min(minDot, glm::dot(axis, n / length));
+    }
+    meshlet.coneAxis = axis;
+    // 超过半球时锥无意义
+    if (minDot > 0.0f)
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+std::vector<Meshlet> BuildMeshlets(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount,
+                                   size_t maxVertices, size_t maxTriangles)
+{
+    size_t triangleCount = indexCount / 3;
+
+    // 顶点 -> 三角形邻接（CSR）
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacencyOffsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    {
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<char> emitted(triangleCount, 0);
+    // 顶点属于哪个簇（簇编号+1），用于统计簇内顶点数
+    std::vector<unsigned int> vertexMeshlet(vertexCount, 0);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(triangleCount * 3);
+    std::vector<Meshlet> meshlets;
+    std::vector<unsigned int> frontier;
+
+    // 种子按原有顺序（顶点缓存优化后的顺序）选取，簇沿邻接广度优先生长
+    for (size_t seed = 0; seed < triangleCount; seed++)
+    {
+        if (emitted[seed])
+            continue;
+
+        unsigned int stamp = (unsigned int)meshlets.size() + 1;
+        Meshlet meshlet{};
+        meshlet.firstIndex = (unsigned int)reordered.size();
+        size_t meshletVertices = 0, triangles = 0;
+
+        frontier.clear();
+        frontier.push_back((unsigned int)seed);
+        for (size_t head = 0; head < frontier.size() && triangles < maxTriangles; head++)
+        {
+            unsigned int t = frontier[head];
+            if (emitted[t])
+                continue;
+            const unsigned int *tri = indices + t * 3;
+            size_t newVertices = 0;
+            for (int k = 0; k < 3; k++)
+                newVertices += vertexMeshlet[tri[k]] != stamp;
+            if (meshletVertices + newVertices > maxVertices)
+                continue;
+
+            emitted[t] = 1;
+            triangles++;
+            meshletVertices += newVertices;
+            for (int k = 0; k < 3; k++)
+            {
+                vertexMeshlet[tri[k]] = stamp;
+                reordered.push_back(tri[k]);
+                for (unsigned int a = adjacencyOffsets[tri[k]]; a < adjacencyOffsets[tri[k] + 1]; a++)
+                {
+                    if (!emitted[adjacency[a]])
+                        frontier.push_back(adjacency[a]);
+                }
+            }
+        }
+
+        meshlet.indexCount = (unsigned int)(triangles * 3);
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+    for (auto &meshlet : meshlets)
+    {
+        ComputeMeshletBounds(meshlet, indices, vertices);
+    }
+    return meshlets;
+}
+
+void CullMeshlets(const std::vector<Meshlet> &meshlets, const glm::mat4 &modelViewProj, const glm::vec3 &cameraLocal,
+                  bool cullBackfaces, std::vector<IndexRange> &ranges, MeshletCullStats &stats)
+{
+    // 局部空间的6个裁剪平面
+    Frustum frustum = Frustum::FromMatrix(modelViewProj);
+
+    stats.total += meshlets.size();
+    size_t rangeBegin = 0, rangeEnd = 0; // 当前合并中的可见区间 [begin, end)，单位为索引
+    bool hasRange = false;
+    for (const Meshlet &meshlet : meshlets)
+    {
+        bool visible = true;
+        for (const auto &plane : frustum.planes)
+        {
+            if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius)
+            {
+                visible = false;
+                break;
+            }
+        }
+        if (!visible)
+        {
+            stats.frustumCulled++;
+            continue;
+        }
+
+        if (cullBackfaces)
+        {
+            glm::vec3 toCenter = meshlet.center - cameraLocal;
+            if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+            {
+                stats.backfaceCulled++;
+                continue;
+            }
+        }
+
+        stats.trianglesSubmitted += meshlet.indexCount / 3;
+        if (hasRange && rangeEnd == meshlet.firstIndex)
+        {
+            rangeEnd += meshlet.indexCount;
+            continue;
+        }
+        if (hasRange)
+        {
+            ranges.push_back({(unsigned int)rangeBegin, (unsigned int)(rangeEnd - rangeBegin)});
+        }
+        rangeBegin = meshlet.firstIndex;
+        rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+        hasRange = true;
+    }
+    if (hasRange)
+    {
+        ranges.push_back({(unsigned int)rangeBegin, (unsigned int)(rangeEnd - rangeBegin)});
+    }
+}
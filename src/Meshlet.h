@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// 一段连续的索引，单位为索引个数
+struct IndexRange
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+// 一簇相邻三角形，索引在Mesh::indices中连续存放，包围球/法线锥都在模型局部空间
+struct Meshlet
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff; // 法线锥张角的正弦，>=1表示法线太分散，不做背面剔除
+};
+
+// 沿三角形邻接关系把[0, indexCount)分成簇（每簇最多maxVertices个顶点/maxTriangles个三角形），
+// 并就地重排indices使每个簇连续；vertices为8个float交错格式
+std::vector<Meshlet> BuildMeshlets(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount,
+                                   size_t maxVertices = 64, size_t maxTriangles = 124);
+
+struct MeshletCullStats
+{
+    size_t total = 0;
+    size_t frustumCulled = 0;
+    size_t backfaceCulled = 0;
+    size_t trianglesSubmitted = 0;
+};
+
+// 逐簇做视锥剔除和（可选的）法线锥背面剔除，相邻的可见簇合并成一个区间追加到ranges
+// modelViewProj和cameraLocal都对应模型局部空间
+void CullMeshlets(const std::vector<Meshlet> &meshlets, const glm::mat4 &modelViewProj, const glm::vec3 &cameraLocal,
+                  bool cullBackfaces, std::vector<IndexRange> &ranges, MeshletCullStats &stats);
@@ -8,6 +8,10 @@
 #include "Renderer.h"
 #include "MeshManager.h"
 #include "SceneManager.h"
+#include "MeshCache.h"
+#include "RigParser.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 
 aiMatrix4x4 GetGlobalTransform(aiNode *node)
 {
@@ -60,80 +64,88 @@ Vector3 GetBoneTailExact(aiNode *node)
 }
 
 void Model::awake()
+{
+    if (load())
+        upload();
+}
+
+bool Model::load()
 {
     Path filepath = directory + filename;
-    Assimp::Importer imp;
-    const aiScene *scene = imp.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        std::cout << "ERROR::ASSIMP::" << imp.GetErrorString() << std::endl;
-        return;
-    }
-    processNode(scene->mRootNode, scene);
 
-    // if needing to normalize the whole model
-    if (normalizeMesh)
+    // 优先读取二进制缓存，源文件没变时跳过Assimp
+    if (!useMeshCache || !MeshCache::Load(filepath, *this))
     {
-        // 第一步：计算所有mesh的全局边界
-        float globalMinX = std::numeric_limits<float>::max();
-        float globalMaxX = std::numeric_limits<float>::lowest();
-        float globalMinY = std::numeric_limits<float>::max();
-        float globalMaxY = std::numeric_limits<float>::lowest();
-        float globalMinZ = std::numeric_limits<float>::max();
-        float globalMaxZ = std::numeric_limits<float>::lowest();
-
-        // 计算所有mesh的全局边界
-        for (auto &mesh : meshes)
+        Assimp::Importer imp;
+        // 顶点缓存优化和LOD简化需要共享顶点的索引网格，只在开启时合并重复顶点，否则保持原始顶点/索引
+        unsigned int flags = aiProcess_Triangulate | aiProcess_FlipUVs;
+        if (optimizeMesh || generateLods)
+            flags |= aiProcess_JoinIdenticalVertices;
+        const aiScene *scene = imp.ReadFile(filepath, flags);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
-            float minX = mesh->vertices[0], maxX = mesh->vertices[0];
-            float minY = mesh->vertices[1], maxY = mesh->vertices[1];
-            float minZ = mesh->vertices[2], maxZ = mesh->vertices[2];
+            std::cout << "ERROR::ASSIMP::" << imp.GetErrorString() << std::endl;
+            return false;
+        }
+        processNode(scene->mRootNode, scene);
 
-#pragma omp parallel for reduction(min : minX, minY, minZ) reduction(max : maxX, maxY, maxZ)
-            for (int i = 1; i < mesh->v_num; i++)
+        if (optimizeMesh)
+        {
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                MeshOptimizeStats stats = OptimizeMesh(*meshes[i]);
+                std::cout << std::format("[MeshOptimizer] {} mesh{}: ACMR {:.3f} -> {:.3f}", filename, i, stats.acmrBefore, stats.acmrAfter) << std::endl;
+            }
+        }
+
+        if (buildMeshlets)
+        {
+            // 在生成LOD之前划分，此时indices只有LOD0
+            for (auto &mesh : meshes)
             {
-                float x = mesh->vertices[i * 8 + 0];
-                float y = mesh->vertices[i * 8 + 1];
-                float z = mesh->vertices[i * 8 + 2];
-
-                if (x < minX)
-                    minX = x;
-                if (x > maxX)
-                    maxX = x;
-                if (y < minY)
-                    minY = y;
-                if (y > maxY)
-                    maxY = y;
-                if (z < minZ)
-                    minZ = z;
-                if (z > maxZ)
-                    maxZ = z;
+                mesh->meshlets = BuildMeshlets(mesh->indices, (size_t)mesh->i_num, mesh->vertices, (size_t)mesh->v_num);
             }
+        }
 
-// 更新全局边界
-#pragma omp critical
+        if (generateLods)
+        {
+            for (size_t i = 0; i < meshes.size(); i++)
             {
-                if (minX < globalMinX)
-                    globalMinX = minX;
-                if (maxX > globalMaxX)
-                    globalMaxX = maxX;
-                if (minY < globalMinY)
-                    globalMinY = minY;
-                if (maxY > globalMaxY)
-                    globalMaxY = maxY;
-                if (minZ < globalMinZ)
-                    globalMinZ = minZ;
-                if (maxZ > globalMaxZ)
-                    globalMaxZ = maxZ;
+                GenerateLods(*meshes[i]);
+                std::string counts;
+                for (auto &lod : meshes[i]->lods)
+                    counts += std::format(" {}", lod.indexCount / 3);
+                std::cout << std::format("[MeshSimplifier] {} mesh{}: {} LODs, triangles:{}", filename, i, meshes[i]->LodCount(), counts) << std::endl;
             }
         }
 
+        if (useMeshCache)
+        {
+            MeshCache::Store(filepath, *this);
+        }
+    }
+
+    if (!rigFile.empty())
+    {
+        LoadRigFile(rigFile);
+    }
+
+    // if needing to normalize the whole model
+    if (normalizeMesh && !meshes.empty())
+    {
+        // 由每个mesh的包围盒合并出全局边界
+        Vector3 globalMin = meshes[0]->boundsMin;
+        Vector3 globalMax = meshes[0]->boundsMax;
+        for (auto &mesh : meshes)
+        {
+            globalMin = glm::min(globalMin, mesh->boundsMin);
+            globalMax = glm::max(globalMax, mesh->boundsMax);
+        }
+
         // 计算全局的中心点和缩放因子
-        float globalCenterX = (globalMinX + globalMaxX) / 2.0f;
-        float globalCenterY = (globalMinY + globalMaxY) / 2.0f;
-        float globalCenterZ = (globalMinZ + globalMaxZ) / 2.0f;
-        globalCenter = Vector3(globalCenterX, globalCenterY, globalCenterZ);
-        globalScale = std::max({globalMaxX - globalMinX, globalMaxY - globalMinY, globalMaxZ - globalMinZ});
+        globalCenter = (globalMin + globalMax) / 2.0f;
+        Vector3 extent = globalMax - globalMin;
+        globalScale = std::max({extent.x, extent.y, extent.z});
 
         // 避免除零
         if (globalScale < 1e-6f)
@@ -144,25 +156,96 @@ void Model::awake()
         {
             globalScale = 1.0f / globalScale;
         }
+    }
+    return true;
+}
 
+void Model::upload()
+{
+    for (int i = 0; i < meshes.size(); i++)
+    {
+        meshes[i]->vertexFormat = vertexFormat;
+        meshes[i] = MeshManager::Instance().AddMesh(meshKeys[i], meshes[i]);
+        Renderer::Instance().ReserveMeshletScratch(meshes[i]->meshlets.size());
+    }
+
+    if (normalizeMesh)
+    {
         // 更改model的transform
         transform.position(-globalCenter * globalScale);
         transform.scale(Vector3(globalScale));
     }
 }
 
+bool Model::LoadRigFile(const std::string &path)
+{
+    RigData rig;
+    if (!RigParser::ParseFile(path, rig))
+        return false;
+
+    // 每个关节的子关节位置之和，tail取子关节的平均位置
+    std::vector<Vector3> childSum(rig.JointCount(), Vector3(0.0f));
+    std::vector<int> childCount(rig.JointCount(), 0);
+    for (auto [parent, child] : rig.edges)
+    {
+        childSum[parent] += rig.positions[child];
+        childCount[parent]++;
+    }
+
+    for (int id = 0; id < rig.JointCount(); id++)
+    {
+        Vector3 head = rig.positions[id];
+        Vector3 tail = head; // 默认tail = head
+        if (childCount[id] > 0)
+        {
+            tail = childSum[id] / (float)childCount[id];
+        }
+
+        std::string parent = rig.parents[id] >= 0 ? rig.names[rig.parents[id]] : "none";
+        bones[rig.names[id]] = std::make_tuple(head, tail, parent);
+    }
+    return true;
+}
+
 Model::~Model()
 {
 }
 
 void Model::draw()
 {
+    glm::mat4 modelMatrix = transform.localToWorld();
     for (int i = 0; i < meshes.size(); i++)
     {
-        Renderer::Instance().SubmitDrawCall({meshes[i], material, transform.localToWorld()});
+        int lod = meshes[i]->LodCount() > 1 ? SelectLod(*meshes[i], modelMatrix) : 0;
+        Renderer::Instance().SubmitDrawCall({meshes[i], material, modelMatrix, lod});
     }
 }
 
+int Model::SelectLod(const Mesh &mesh, const glm::mat4 &modelMatrix) const
+{
+    auto camera = SceneManager::GetMainCamera();
+    if (!camera)
+        return 0;
+
+    // 世界空间包围球
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(mesh.boundsCenter, 1.0f));
+    float maxScale = std::max({glm::length(glm::vec3(modelMatrix[0])),
+                               glm::length(glm::vec3(modelMatrix[1])),
+                               glm::length(glm::vec3(modelMatrix[2]))});
+    float radius = mesh.boundsRadius * maxScale;
+
+    float distance = glm::length(center - glm::vec3(camera->transform.position()));
+    if (distance <= radius)
+        return 0;
+
+    // 包围球投影高度占屏幕高度的比例
+    float coverage = radius / (distance * std::tan(glm::radians(camera->fieldView) * 0.5f));
+    if (coverage >= lodBias)
+        return 0;
+    int level = (int)(2.0f * std::log2(lodBias / coverage));
+    return std::min(level, mesh.LodCount() - 1);
+}
+
 std::string Model::info()
 {
     int sumFace = 0;
@@ -189,52 +272,40 @@ void Model::printBoneInfo()
     }
 }
 
-void Model::AddBoneNodes(const std::shared_ptr<Material> &nodeMaterial, const std::shared_ptr<Material> &linkMaterial)
+std::shared_ptr<Skeleton> Model::AddSkeleton(const std::shared_ptr<Material> &material, const glm::vec4 &nodeColor,
+                                             const glm::vec4 &linkColor)
 {
-    for (auto it : bones)
+    auto skeleton = std::dynamic_pointer_cast<Skeleton>(SceneObject::create("Skeleton", filename + "_skeleton"));
+    skeleton->material = material;
+    skeleton->nodeColor = nodeColor;
+    skeleton->linkColor = linkColor;
+
+    // 名字只在这里解析一次，之后都用下标
+    std::unordered_map<std::string, int> jointIndex;
+    jointIndex.reserve(bones.size());
+    skeleton->heads.reserve(bones.size());
+    skeleton->tails.reserve(bones.size());
+    for (auto &[name, bone] : bones)
     {
-        auto [nodeNmae, headAndTail] = it;
-        auto [head, tail, parentName] = headAndTail;
-        auto nodeObj = std::dynamic_pointer_cast<Model>(SceneObject::create("Model", filename + "_" + nodeNmae));
-        nodeObj->directory = Path(ROOT_DIR) + "/assets";
-        nodeObj->filename = "ico-sphere.obj";
-        nodeObj->SetMaterial(nodeMaterial);
-        nodeObj->awake();
-        nodeObj->transform.scale(Vector3(0.01f));
-        nodeObj->transform.position((head - globalCenter) * globalScale);
-        SceneManager::AddObject(nodeObj);
-        children.push_back(nodeObj);
-
-        if (!parentName.empty() && bones.find(parentName) != bones.end())
-        {
-            auto parentHead = std::get<0>(bones[parentName]);
-            auto linkObj = std::dynamic_pointer_cast<Model>(SceneObject::create("Model", filename + "_" + parentName + "-" + nodeNmae));
-            linkObj->directory = Path(ROOT_DIR) + "/assets";
-            linkObj->filename = "cone.obj";
-            linkObj->SetMaterial(linkMaterial);
-            linkObj->awake();
-
-            Vector3 direction = glm::normalize(head - parentHead);
-            float length = glm::distance(head, parentHead);
-
-            // 计算圆锥体的缩放
-            // cone.obj原始高度为2，所以需要缩放为实际骨骼长度的一半
-            float heightScale = length / 2.0f;
-            // 半径可以根据需要调整，这里设为高度的1/10
-            float radiusScale = heightScale * 0.1f;
-            glm::vec3 coneScale = glm::vec3(radiusScale, heightScale, radiusScale);
-            linkObj->transform.scale(coneScale * globalScale);
-
-            // 计算旋转
-            glm::vec3 originalDirection(0.0f, 1.0f, 0.f); // cone.obj原始朝向（高度方向）
-            linkObj->transform.rotate(originalDirection, direction);
-
-            // 计算位置
-            linkObj->transform.position((parentHead - globalCenter) * globalScale);
-            SceneManager::AddObject(linkObj);
-            children.push_back(linkObj);
-        }
+        jointIndex[name] = (int)skeleton->heads.size();
+        skeleton->heads.push_back(std::get<0>(bone));
+        skeleton->tails.push_back(std::get<1>(bone));
     }
+    skeleton->parents.assign(bones.size(), -1);
+    for (auto &[name, bone] : bones)
+    {
+        auto parent = jointIndex.find(std::get<2>(bone));
+        if (parent != jointIndex.end())
+            skeleton->parents[jointIndex[name]] = parent->second;
+    }
+
+    // 关节坐标在模型空间，作为子对象跟随模型的变换（包括归一化）；球半径换算到模型空间，世界空间中保持0.01
+    skeleton->nodeRadius = 0.01f / globalScale;
+    skeleton->MarkDirty();
+
+    SceneManager::AddObject(skeleton);
+    AddChild(skeleton);
+    return skeleton;
 }
 
 void Model::processNode(aiNode *node, const aiScene *scene)
@@ -242,7 +313,9 @@ void Model::processNode(aiNode *node, const aiScene *scene)
     for (int i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(MeshManager::Instance().LoadMesh(mesh, scene, std::format("{}/{}_{}", std::string(directory), filename, meshes.size())));
+        // 这里只构建CPU侧数据，upload()时再交给MeshManager缓存并上传
+        meshKeys.push_back(std::format("{}/{}_{}", std::string(directory), filename, meshes.size()));
+        meshes.push_back(std::make_shared<Mesh>(mesh, scene, directory));
         for (unsigned int b = 0; b < mesh->mNumBones; ++b)
         {
             aiBone *bone = mesh->mBones[b];
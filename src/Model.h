@@ -6,6 +6,7 @@
 #include "SceneObject.h"
 #include "Path.h"
 #include "Material.h"
+#include "Skeleton.h"
 
 class Model : public SceneObject
 {
@@ -14,26 +15,48 @@ public:
 
     std::shared_ptr<Material> material;
     std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::string> meshKeys; // 与meshes一一对应，在MeshManager中的key
     std::unordered_map<std::string, std::tuple<Vector3, Vector3, std::string>> bones; // name-> <head, tail, parentName>
 
     ~Model() override;
 
+    // 同步加载：load() + upload()
     void awake() override;
+
+    // 只做CPU侧工作（Assimp导入、顶点交错、rig解析、归一化参数），不调用GL，可以在工作线程执行
+    bool load();
+    // 主线程调用：把meshes注册到MeshManager并上传GPU，应用归一化变换
+    void upload();
+
     void update() override {}
     void draw() override;
 
     void SetMaterial(const std::shared_ptr<Material> mat) { material = std::move(mat); }
     std::string info();
     void printBoneInfo();
+    // 根据mesh包围球在主相机中的屏幕占比选择LOD级别
+    int SelectLod(const Mesh &mesh, const glm::mat4 &modelMatrix) const;
+
+    // 把bones转成一个Skeleton加入场景并作为子对象，material需使用skeleton.shader
+    std::shared_ptr<Skeleton> AddSkeleton(const std::shared_ptr<Material> &material, const glm::vec4 &nodeColor,
+                                          const glm::vec4 &linkColor);
 
-    // add bone nodes to scene, visualize with nodeMaterial
-    void AddBoneNodes(const std::shared_ptr<Material> &nodeMaterial, const std::shared_ptr<Material> &linkMaterial);
+    // 读取rignet输出的骨骼文件xxx.txt
+    bool LoadRigFile(const std::string &path);
 
     void processNode(aiNode *node, const aiScene *scene);
     Path directory;
     std::string filename;
+    std::string rigFile; // 为空则不加载
 
     bool normalizeMesh = false;
+    bool useMeshCache = true; // 是否读写二进制mesh缓存（见MeshCache）
+    VertexFormat vertexFormat = VertexFormat::Float32; // 上传到GPU时的顶点格式
+    bool optimizeMesh = false; // 导入后重排索引/顶点（顶点缓存、overdraw、拉取局部性），结果会写入缓存
+    bool buildMeshlets = false; // 导入后把LOD0划分成簇用于逐簇剔除，结果会写入缓存
+    bool generateLods = false; // 导入后用QEM简化生成LOD链，结果会写入缓存
+    // 包围球在屏幕上的高度占比低于lodBias时开始切换LOD，占比每减半降两级（每级三角形约减半）
+    float lodBias = 0.5f;
     Vector3 globalCenter = Vector3(0.0f);;
     float globalScale = 1.0f;
 };
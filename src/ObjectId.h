@@ -0,0 +1,12 @@
+#pragma once
+#include <atomic>
+
+// 每个类型独立计数的小整数ID，从1开始按创建顺序递增，不复用
+// 用于排序键等需要跨运行稳定顺序的地方（裸指针的大小关系每次运行都不一样）
+// 要跨运行稳定，调用顺序本身必须确定：在主线程上按固定顺序分配，不要在工作线程中分配
+template <typename T>
+unsigned int NextObjectId()
+{
+    static std::atomic<unsigned int> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,140 @@
+#include "OitPass.h"
+#include "GLState.h"
+#include "Path.h"
+#include "config.h"
+#include <iostream>
+
+static constexpr uint32_t ID_ACCUM_TEXTURE = Shader::PropertyToID("accumTexture");
+static constexpr uint32_t ID_REVEALAGE_TEXTURE = Shader::PropertyToID("revealageTexture");
+static constexpr uint32_t ID_NEAREST_DEPTH_TEXTURE = Shader::PropertyToID("nearestDepthTexture");
+static constexpr uint32_t ID_SCENE_DEPTH_TEXTURE = Shader::PropertyToID("sceneDepthTexture");
+
+void OitPass::DeleteTargets()
+{
+    GLState &state = GLState::Instance();
+    GLuint textures[] = {accumTexture, revealageTexture, nearestDepthTexture, depthTexture};
+    for (GLuint texture : textures)
+    {
+        if (texture)
+        {
+            state.ForgetTexture(texture);
+            glDeleteTextures(1, &texture);
+        }
+    }
+    if (framebuffer)
+        glDeleteFramebuffers(1, &framebuffer);
+    framebuffer = accumTexture = revealageTexture = nearestDepthTexture = depthTexture = 0;
+    width = height = 0;
+}
+
+void OitPass::Resize(int newWidth, int newHeight)
+{
+    DeleteTargets();
+    width = newWidth;
+    height = newHeight;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &accumTexture);
+    glTextureStorage2D(accumTexture, 1, GL_RGBA16F, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &revealageTexture);
+    glTextureStorage2D(revealageTexture, 1, GL_R8, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &nearestDepthTexture);
+    glTextureStorage2D(nearestDepthTexture, 1, GL_R32F, width, height);
+    // 格式与默认帧缓冲的深度一致，才能用glBlitFramebuffer复制
+    glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+    glTextureStorage2D(depthTexture, 1, GL_DEPTH24_STENCIL8, width, height);
+    for (GLuint texture : {accumTexture, revealageTexture, nearestDepthTexture, depthTexture})
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, accumTexture, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, revealageTexture, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT2, nearestDepthTexture, 0);
+    glNamedFramebufferTexture(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, depthTexture, 0);
+    GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glNamedFramebufferDrawBuffers(framebuffer, 3, drawBuffers);
+    if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "[OitPass] framebuffer incomplete (" << width << "x" << height << ")" << std::endl;
+    }
+}
+
+void OitPass::Begin()
+{
+    if (!compositeShader)
+    {
+        compositeShader = std::make_shared<Shader>(std::unordered_map<ShaderVariant, std::string>{
+            {ShaderVariant::Basic, Path(ROOT_DIR) + "assets/shader/oit_composite.shader"}});
+        glGenVertexArrays(1, &emptyVao);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (viewport[2] != width || viewport[3] != height)
+        Resize(viewport[2], viewport[3]);
+
+    // 不透明物体已经画进默认帧缓冲，复制深度让透明物体被正确遮挡
+    glBlitNamedFramebuffer(0, framebuffer, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    static const float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    static const float one[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glClearBufferfv(GL_COLOR, 0, zero);
+    glClearBufferfv(GL_COLOR, 1, one);
+    glClearBufferfv(GL_COLOR, 2, one);
+}
+
+void OitPass::ApplyBlendState(bool writeDepth)
+{
+    GLState &state = GLState::Instance();
+    state.SetDepthWrite(false);
+    state.SetBlend(true);
+    // 累积：sum(color * alpha * w, alpha * w)；透明度：prod(1 - alpha)；最近深度：min(z)
+    state.SetBlendFunci(0, GL_ONE, GL_ONE);
+    state.SetBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    state.SetBlendFunci(2, GL_ONE, GL_ONE);
+    glBlendEquationi(2, GL_MIN);
+    glColorMaski(2, writeDepth, GL_FALSE, GL_FALSE, GL_FALSE);
+}
+
+void OitPass::End()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glColorMaski(2, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // 着色器输出min(最近深度, 场景深度)，场景深度取Begin()时复制的那份（OIT pass中没有写过）
+    GLState &state = GLState::Instance();
+    state.SetDepthTest(true);
+    state.SetDepthFunc(GL_ALWAYS);
+    state.SetDepthWrite(true);
+    state.SetCullFace(false);
+    state.SetBlend(true);
+    state.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    compositeShader->Use();
+    state.BindTexture(0, accumTexture);
+    state.BindTexture(1, revealageTexture);
+    state.BindTexture(2, nearestDepthTexture);
+    state.BindTexture(3, depthTexture);
+    compositeShader->SetUniform1i(ID_ACCUM_TEXTURE, 0);
+    compositeShader->SetUniform1i(ID_REVEALAGE_TEXTURE, 1);
+    compositeShader->SetUniform1i(ID_NEAREST_DEPTH_TEXTURE, 2);
+    compositeShader->SetUniform1i(ID_SCENE_DEPTH_TEXTURE, 3);
+    state.BindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void OitPass::Release()
+{
+    DeleteTargets();
+    if (emptyVao)
+    {
+        GLState::Instance().ForgetVertexArray(emptyVao);
+        glDeleteVertexArrays(1, &emptyVao);
+        emptyVao = 0;
+    }
+    compositeShader.reset();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <GL/glew.h>
+#include "Shader.h"
+
+// 加权混合顺序无关透明（weighted blended OIT，McGuire & Bavoil 2013）
+// Begin()：复制默认帧缓冲的深度，清空累积目标（RGBA16F，清为0）和透明度目标（R8，清为1）
+// 之后透明物体用ShaderPass::Oit的program以任意顺序绘制，只做深度测试、不写深度缓冲
+// 开启了depthWrite的材质另外把片元深度以GL_MIN混合进最近深度目标（R32F，清为1）
+// End()：回到默认帧缓冲，用全屏三角形把 accum.rgb / accum.a 按 1 - revealage 的不透明度混合到场景上，
+// 同时把最近深度写回深度缓冲，深度读回（例如截图）仍能看到半透明物体
+// 必须在主线程使用
+class OitPass
+{
+public:
+    OitPass() = default;
+    OitPass(const OitPass &) = delete;
+    OitPass &operator=(const OitPass &) = delete;
+
+    void Begin();
+    // 应用材质的渲染状态之后调用，改为OIT需要的混合方式；writeDepth即材质的depthWrite
+    void ApplyBlendState(bool writeDepth);
+    void End();
+    // 释放GL资源，需在GL上下文销毁前调用
+    void Release();
+
+private:
+    // 按视口大小（重新）创建渲染目标
+    void Resize(int width, int height);
+    void DeleteTargets();
+
+    GLuint framebuffer = 0;
+    GLuint accumTexture = 0;
+    GLuint revealageTexture = 0;
+    GLuint nearestDepthTexture = 0;
+    GLuint depthTexture = 0;
+    GLuint emptyVao = 0; // 全屏三角形由gl_VertexID生成，不需要顶点数据
+    int width = 0;
+    int height = 0;
+    std::shared_ptr<Shader> compositeShader;
+};
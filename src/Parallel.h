@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include "JobSystem.h"
+
+// 把[begin, end)切成若干块并行执行 func(chunkBegin, chunkEnd)，由JobSystem的工作线程和当前线程共同完成
+// 元素数少于grain时直接在当前线程执行
+template <typename Func>
+void ParallelFor(size_t begin, size_t end, size_t grain, Func &&func)
+{
+    JobSystem::Instance().ParallelFor(begin, end, grain, std::forward<Func>(func));
+}
@@ -0,0 +1,137 @@
+#include "PrimitiveRegistry.h"
+#include <map>
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MeshManager.h"
+
+static void PushVertex(std::vector<float> &vertices, const glm::vec3 &pos, const glm::vec3 &normal)
+{
+    vertices.insert(vertices.end(), {pos.x, pos.y, pos.z, normal.x, normal.y, normal.z, 0.0f, 0.0f});
+}
+
+static std::shared_ptr<Mesh> GenerateIcoSphere(int subdivisions)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+    for (auto &p : positions)
+        p = glm::normalize(p);
+
+    std::vector<unsigned int> indices = {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+
+    for (int s = 0; s < subdivisions; s++)
+    {
+        // 共享边的中点只生成一次
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b)
+        {
+            auto key = std::minmax(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            unsigned int idx = (unsigned int)positions.size() - 1;
+            midpoints[key] = idx;
+            return idx;
+        };
+
+        std::vector<unsigned int> subdivided;
+        subdivided.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+        indices.swap(subdivided);
+    }
+
+    std::vector<float> vertices;
+    vertices.reserve(positions.size() * 8);
+    for (auto &p : positions)
+        PushVertex(vertices, p, p); // 单位球上法线等于位置
+
+    return std::make_shared<Mesh>(vertices, indices);
+}
+
+static std::shared_ptr<Mesh> GenerateCone(int segments)
+{
+    // 与原cone.obj一致：底面半径1，高2
+    const float radius = 1.0f;
+    const float height = 2.0f;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    vertices.reserve(segments * 3 * 8);
+
+    // 侧面法线按斜率计算：normalize(h·cos, r, h·sin)
+    auto sideNormal = [&](float angle)
+    {
+        glm::vec3 radial(-std::sin(angle), 0.0f, std::cos(angle));
+        return glm::normalize(radial * height + glm::vec3(0.0f, radius, 0.0f));
+    };
+    auto ringPosition = [&](float angle)
+    { return glm::vec3(-std::sin(angle), 0.0f, std::cos(angle)) * radius; };
+
+    // 侧面环 [0, segments)
+    for (int i = 0; i < segments; i++)
+    {
+        float angle = 2.0f * 3.14159265f * i / segments;
+        PushVertex(vertices, ringPosition(angle), sideNormal(angle));
+    }
+    // 顶点处法线不唯一，每个侧面三角形一个顶点，取该面中间角度的法线 [segments, 2*segments)
+    for (int i = 0; i < segments; i++)
+    {
+        float angle = 2.0f * 3.14159265f * (i + 0.5f) / segments;
+        PushVertex(vertices, glm::vec3(0.0f, height, 0.0f), sideNormal(angle));
+    }
+    // 底面环，法线朝下 [2*segments, 3*segments)
+    for (int i = 0; i < segments; i++)
+    {
+        float angle = 2.0f * 3.14159265f * i / segments;
+        PushVertex(vertices, ringPosition(angle), glm::vec3(0.0f, -1.0f, 0.0f));
+    }
+
+    // 侧面
+    for (int i = 0; i < segments; i++)
+    {
+        indices.insert(indices.end(), {(unsigned int)i, (unsigned int)(segments + i), (unsigned int)((i + 1) % segments)});
+    }
+    // 底面扇形
+    unsigned int base = 2 * segments;
+    for (int i = 1; i < segments - 1; i++)
+    {
+        indices.insert(indices.end(), {base, base + i + 1, base + i});
+    }
+
+    return std::make_shared<Mesh>(vertices, indices);
+}
+
+std::shared_ptr<Mesh> PrimitiveRegistry::Get(PrimitiveType type)
+{
+    switch (type)
+    {
+    case PrimitiveType::Sphere:
+        if (!sphere)
+            sphere = MeshManager::Instance().AddMesh("primitive/ico-sphere", GenerateIcoSphere(1));
+        return sphere;
+    case PrimitiveType::Cone:
+        if (!cone)
+            cone = MeshManager::Instance().AddMesh("primitive/cone", GenerateCone(32));
+        return cone;
+    }
+    return nullptr;
+}
+
+void PrimitiveRegistry::Clear()
+{
+    sphere.reset();
+    cone.reset();
+}
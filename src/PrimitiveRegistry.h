@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+#include "Mesh.h"
+
+enum class PrimitiveType
+{
+    Sphere, // ico-sphere，半径1，细分1次（与assets/ico-sphere.obj一致）
+    Cone    // 底面半径1，高2，底面在y=0，尖端朝+y（与assets/cone.obj一致）
+};
+
+// 骨骼可视化用到的共享几何体
+// 每个进程只程序化生成一次，所有关节/连线共享同一个Mesh，不产生任何文件IO
+class PrimitiveRegistry
+{
+public:
+    static PrimitiveRegistry &Instance()
+    {
+        static PrimitiveRegistry instance;
+        return instance;
+    }
+    PrimitiveRegistry(const PrimitiveRegistry &) = delete;
+    PrimitiveRegistry &operator=(const PrimitiveRegistry &) = delete;
+
+    // 主线程调用，第一次使用时生成并上传GPU
+    std::shared_ptr<Mesh> Get(PrimitiveType type);
+
+    // 释放GPU资源，需在GL上下文销毁前调用
+    void Clear();
+
+private:
+    PrimitiveRegistry() = default;
+
+    std::shared_ptr<Mesh> sphere;
+    std::shared_ptr<Mesh> cone;
+};
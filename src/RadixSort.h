@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// 按64位的item.key做LSD基数排序，每轮8位；某一字节所有键都相同时跳过这一轮
+// 稳定排序，items和scratch轮流作为输出，返回结果所在的数组
+template <typename Item>
+Item *RadixSortByKey(Item *items, Item *scratch, size_t count)
+{
+    if (count == 0)
+        return items;
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+            histogram[(items[i].key >> shift) & 0xFF]++;
+        if (histogram[(items[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (size_t &bucket : histogram)
+        {
+            size_t n = bucket;
+            bucket = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++)
+            scratch[histogram[(items[i].key >> shift) & 0xFF]++] = items[i];
+        std::swap(items, scratch);
+    }
+    return items;
+}
@@ -1,137 +1,447 @@
 #include "Renderer.h"
+#include "GLState.h"
+#include "FrustumCull.h"
+#include "Parallel.h"
+#include "RadixSort.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
 
-uint64_t MakeSortKey(const std::shared_ptr<Material> &material,
-                     const std::shared_ptr<Mesh> &mesh)
+static constexpr uint32_t ID_VIEW = Shader::PropertyToID("view");
+static constexpr uint32_t ID_PROJECTION = Shader::PropertyToID("projection");
+static constexpr uint32_t ID_MODEL = Shader::PropertyToID("model");
+
+// 视锥剔除每个任务处理的提交数，少于这个数不拆分
+static constexpr size_t CULL_GRAIN = 2048;
+
+static bool IsTransparentQueue(unsigned int queue)
 {
-    auto h1 = reinterpret_cast<uint64_t>(material.get());
-    auto h2 = reinterpret_cast<uint64_t>(mesh.get());
-    return (h1 << 24) ^ (h2 & 0xFFFFFF);
+    return queue >= RenderQueue::Transparent && queue < RenderQueue::Overlay;
 }
 
-void Renderer::SubmitDrawCall(const DrawCall &drawCall)
+static uint32_t DepthBits(float depth)
 {
-    std::shared_ptr<Material> material = drawCall.material;
-    if (material->renderQueue >= RenderQueue::Transparent && material->renderQueue < RenderQueue::Overlay)
+    depth = std::max(depth, 0.0f);
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+uint64_t Renderer::MakeSortKey(unsigned int queue, const Shader &shader, const Material &material,
+                               const Mesh &mesh, int lod, float viewDepth, bool backToFront)
+{
+    uint64_t key = (uint64_t)std::min(queue, 0xFFFu) << 52;
+    if (backToFront)
     {
-        renderQueues[material->renderQueue].transparentDrawCalls.push_back(drawCall);
+        key |= (uint64_t)(~DepthBits(viewDepth)) << 20;
+        key |= (uint64_t)(shader.id & 0x3FF) << 10;
+        key |= (uint64_t)(material.id & 0x3FF);
     }
     else
     {
-        renderQueues[material->renderQueue].batches[BatchKey{drawCall.mesh, drawCall.material}].push_back({drawCall.modelMatrix});
+        key |= (uint64_t)(shader.id & 0x3FF) << 42;
+        key |= (uint64_t)(material.id & 0xFFF) << 30;
+        key |= (uint64_t)(mesh.id & 0xFFFF) << 14;
+        key |= (uint64_t)(std::min(lod, 7) & 0x7) << 11;
+        key |= (uint64_t)(DepthBits(viewDepth) >> 21);
     }
+    return key;
 }
 
-void Renderer::FlushBatches(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix)
+TransparencyMode Renderer::GetTransparencyMode(unsigned int queue) const
+{
+    auto it = transparencyModes.find(queue);
+    return it != transparencyModes.end() ? it->second : TransparencyMode::Sorted;
+}
+
+void Renderer::SubmitDrawCall(const DrawCall &drawCall)
+{
+    unsigned int queue = drawCall.material->renderQueue;
+    bool oit = false;
+    if (IsTransparentQueue(queue) && GetTransparencyMode(queue) == TransparencyMode::WeightedBlended)
+        oit = drawCall.material->GetShader()->HasVariant(ShaderVariant::Basic, ShaderPass::Oit);
+    bool backToFront = IsTransparentQueue(queue) && !oit;
+    packets.push_back({drawCall.modelMatrix, drawCall.mesh.get(), drawCall.material.get(), queue, drawCall.lod,
+                       backToFront, oit});
+}
+
+void Renderer::SubmitRenderable(Renderable *renderable, unsigned int queue)
+{
+    renderables.push_back({queue, renderable});
+}
+
+void Renderer::CullPackets()
+{
+    size_t count = packets.size();
+    if (count == 0)
+        return;
+
+    // 局部包围盒变换到世界空间：中心直接变换，半长取|M| * extent（得到包住旋转后盒子的AABB）
+    float *soa = frameArena.Allocate<float>(count * 6);
+    float *centerX = soa, *centerY = soa + count, *centerZ = soa + count * 2;
+    float *extentX = soa + count * 3, *extentY = soa + count * 4, *extentZ = soa + count * 5;
+    uint8_t *visible = frameArena.Allocate<uint8_t>(count);
+    Frustum frustum = Frustum::FromMatrix(viewProj);
+
+    // 提交数多时分块并行，每块各自做变换和SSE测试
+    std::atomic<size_t> visibleCount = 0;
+    ParallelFor(0, count, CULL_GRAIN, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const glm::mat4 &m = packets[i].modelMatrix;
+                        const Mesh &mesh = *packets[i].mesh;
+                        glm::vec3 center = glm::vec3(m * glm::vec4(mesh.boundsCenter, 1.0f));
+                        glm::vec3 extent = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+                        centerX[i] = center.x;
+                        centerY[i] = center.y;
+                        centerZ[i] = center.z;
+                        extentX[i] = std::fabs(m[0][0]) * extent.x + std::fabs(m[1][0]) * extent.y + std::fabs(m[2][0]) * extent.z;
+                        extentY[i] = std::fabs(m[0][1]) * extent.x + std::fabs(m[1][1]) * extent.y + std::fabs(m[2][1]) * extent.z;
+                        extentZ[i] = std::fabs(m[0][2]) * extent.x + std::fabs(m[1][2]) * extent.y + std::fabs(m[2][2]) * extent.z;
+                    }
+                    visibleCount += CullBoxes(frustum, centerX + begin, centerY + begin, centerZ + begin, extentX + begin,
+                                              extentY + begin, extentZ + begin, end - begin, visible + begin); });
+    if (visibleCount == count)
+        return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (visible[i])
+            packets[kept++] = packets[i];
+    }
+    packets.erase(packets.begin() + kept, packets.end());
+    stats.culledDraws = count - kept;
+}
+
+void Renderer::DrawSingle(Mesh &mesh, const Material &material, const std::shared_ptr<Shader> &shader,
+                          const glm::mat4 &modelMatrix, int lod)
 {
-    struct SortedBatch
+    stats.drawCalls++;
+    if (lod != 0 || mesh.meshlets.empty())
     {
-        uint64_t sortKey;
-        std::shared_ptr<Material> material;
-        std::shared_ptr<Mesh> mesh;
-        std::vector<RenderInstance> *instances;
+        stats.trianglesSubmitted += mesh.GetLod(lod).indexCount / 3;
+        mesh.draw(shader, lod);
+        return;
+    }
+
+    // 相机变换到模型局部空间，包围球和法线锥都在局部空间
+    glm::vec3 cameraLocal = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.0f));
+    // 背面剔除只在材质开启了面剔除时才是安全的
+    bool cullBackfaces = material.renderState.cullFace;
+
+    size_t submittedBefore = stats.meshlets.trianglesSubmitted;
+    visibleRanges.clear();
+    CullMeshlets(mesh.meshlets, viewProj * modelMatrix, cameraLocal, cullBackfaces, visibleRanges, stats.meshlets);
+    stats.trianglesSubmitted += stats.meshlets.trianglesSubmitted - submittedBefore;
+    mesh.drawRanges(shader, visibleRanges);
+}
+
+bool Renderer::CanDrawIndirect(const DrawPacket &packet) const
+{
+    return indirectEnabled && !packet.backToFront && packet.mesh->geometry.page && packet.mesh->textures.empty() &&
+           packet.material->GetShader()->HasVariant(ShaderVariant::Indirect,
+                                                    packet.oit ? ShaderPass::Oit : ShaderPass::Forward);
+}
+
+void Renderer::DrawIndirect(const Material &material, const SortItem *items, size_t count)
+{
+    const GeometryPage &page = *packets[items[0].packet].mesh->geometry.page;
+    bool cullBackfaces = material.renderState.cullFace;
+
+    // 命令逐条分配，同一帧中对齐相同的连续分配在缓冲区中是连续的
+    size_t firstCommandOffset = 0;
+    unsigned int commandCount = 0;
+    auto pushCommand = [&](const DrawElementsIndirectCommand &command)
+    {
+        size_t offset = 0;
+        void *dst = indirectBuffer.Allocate(sizeof(command), alignof(DrawElementsIndirectCommand), offset);
+        if (!dst)
+            return;
+        std::memcpy(dst, &command, sizeof(command));
+        if (commandCount == 0)
+            firstCommandOffset = offset;
+        commandCount++;
     };
 
-    for (auto &[rq, bucket] : renderQueues)
+    for (size_t i = 0; i < count;)
     {
-        if (rq < RenderQueue::Transparent || rq >= RenderQueue::Overlay)
+        const DrawPacket &packet = packets[items[i].packet];
+        size_t end = i + 1;
+        while (end < count)
+        {
+            const DrawPacket &next = packets[items[end].packet];
+            if (next.mesh != packet.mesh || next.lod != packet.lod)
+                break;
+            end++;
+        }
+        size_t instances = end - i;
+        Mesh &mesh = *packet.mesh;
+
+        size_t dataOffset = 0;
+        DrawData *data = (DrawData *)drawDataBuffer.Allocate(instances * sizeof(DrawData), sizeof(DrawData), dataOffset);
+        if (!data)
+            break;
+        glm::vec3 scale, offset;
+        mesh.PositionDecode(scale, offset);
+        for (size_t k = i; k < end; k++, data++)
         {
-            std::vector<SortedBatch> sortedBatches;
-            sortedBatches.reserve(bucket.batches.size());
-            for (auto &[key, instances] : bucket.batches)
+            data->modelMatrix = packets[items[k].packet].modelMatrix;
+            data->positionScale = glm::vec4(scale, 0.0f);
+            data->positionOffset = glm::vec4(offset, 0.0f);
+        }
+        unsigned int baseInstance = (unsigned int)((dataOffset - drawDataBuffer.FrameBase()) / sizeof(DrawData));
+
+        if (instances == 1 && packet.lod == 0 && !mesh.meshlets.empty())
+        {
+            // 逐簇剔除后的每个可见区间一条命令，共用同一条逐绘制数据
+            glm::vec3 cameraLocal = glm::vec3(glm::inverse(packet.modelMatrix) * glm::vec4(cameraPosition, 1.0f));
+            size_t submittedBefore = stats.meshlets.trianglesSubmitted;
+            visibleRanges.clear();
+            CullMeshlets(mesh.meshlets, viewProj * packet.modelMatrix, cameraLocal, cullBackfaces, visibleRanges,
+                         stats.meshlets);
+            stats.trianglesSubmitted += stats.meshlets.trianglesSubmitted - submittedBefore;
+            for (const IndexRange &range : visibleRanges)
             {
-                SortedBatch batch;
-                batch.material = key.material;
-                batch.mesh = key.mesh;
-                batch.instances = &instances;
-                batch.sortKey = MakeSortKey(key.material, key.mesh);
-                sortedBatches.push_back(batch);
+                pushCommand({range.indexCount, 1, mesh.geometry.firstIndex + range.firstIndex,
+                             (int)mesh.geometry.baseVertex, baseInstance});
             }
+        }
+        else
+        {
+            MeshLod range = mesh.GetLod(packet.lod);
+            pushCommand({range.indexCount, (unsigned int)instances, mesh.geometry.firstIndex + range.firstIndex,
+                         (int)mesh.geometry.baseVertex, baseInstance});
+            stats.trianglesSubmitted += range.indexCount / 3 * instances;
+        }
+        i = end;
+    }
 
-            std::sort(sortedBatches.begin(), sortedBatches.end(),
-                      [](const SortedBatch &a, const SortedBatch &b)
-                      {
-                          return a.sortKey < b.sortKey;
-                      });
+    if (commandCount == 0)
+        return;
+    GLState &state = GLState::Instance();
+    state.BindVertexArray(page.vao);
+    state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.Buffer());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, page.IndexType(), (const void *)firstCommandOffset, commandCount, 0);
+    stats.drawCalls++;
+    stats.indirectCommands += commandCount;
+}
 
-            std::shared_ptr<Shader> currentShader = nullptr;
+void Renderer::FlushBatches(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix)
+{
+    size_t frameAllocations = stats.frameAllocations;
+    stats = RenderStats();
+    stats.frameAllocations = frameAllocations;
+    viewProj = projMatrix * viewMatrix;
+    cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
 
-            for (auto &batch : sortedBatches)
-            {
-                auto &mesh = batch.mesh;
-                auto &material = batch.material;
-                auto &instances = batch.instances;
+    frameArena.Reset();
+    CullPackets();
 
-                if (currentShader != material->GetShader())
-                {
-                    currentShader = material->GetShader();
-                }
+    // 实例数据最多和提交数一样多，环形缓冲区只在不够时扩容
+    size_t count = packets.size();
+    instanceBuffer.BeginFrame(count * sizeof(glm::mat4));
+    // 间接命令：每次提交最多一条，LOD0逐簇剔除时最多每簇一条
+    size_t maxCommands = count;
+    for (const DrawPacket &packet : packets)
+    {
+        if (packet.lod == 0)
+            maxCommands += packet.mesh->meshlets.size();
+    }
+    drawDataBuffer.BeginFrame(count * sizeof(DrawData));
+    indirectBuffer.BeginFrame(maxCommands * sizeof(DrawElementsIndirectCommand));
+    if (indirectEnabled)
+    {
+        GLState::Instance().BindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, drawDataBuffer.Buffer(),
+                                            drawDataBuffer.FrameBase(), drawDataBuffer.FrameBytes());
+    }
 
-                if (instances->size() > 1)
-                    currentShader->Use(ShaderVariant::Instanced);
-                else
-                    currentShader->Use(ShaderVariant::Basic);
-                currentShader->SetUniformMat4x4f("view", viewMatrix);
-                currentShader->SetUniformMat4x4f("projection", projMatrix);
+    SortItem *items = frameArena.Allocate<SortItem>(count);
+    SortItem *scratch = frameArena.Allocate<SortItem>(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const DrawPacket &packet = packets[i];
+        // OIT与顺序无关，不需要深度，基数排序可以跳过对应的字节
+        float viewDepth = packet.oit ? 0.0f : -(viewMatrix * packet.modelMatrix[3]).z;
+        items[i].key = MakeSortKey(packet.queue, *packet.material->GetShader(), *packet.material, *packet.mesh,
+                                   packet.lod, viewDepth, packet.backToFront);
+        items[i].packet = (unsigned int)i;
+    }
+    // 基数排序是稳定的，键相同的按提交顺序，每次运行顺序一致
+    if (count > 0)
+        items = RadixSortByKey(items, scratch, count);
 
-                material->ApplyRenderState();
-                material->ApplyUniforms();
+    // 只在shader变体/material变化时切换program、上传相机矩阵和材质状态
+    const Shader *currentShader = nullptr;
+    ShaderVariant currentVariant = ShaderVariant::Basic;
+    const Material *currentMaterial = nullptr;
+    bool inOitPass = false;
 
-                if (instances->size() == 1)
-                {
-                    currentShader->SetUniformMat4x4f("model", instances->at(0).modelMatrix);
-                    mesh->draw(currentShader);
-                }
-                else
-                {
-                    // std::cout << "Drawing " << instances->size() << " instances of mesh." << std::endl;
-                    // 实例化渲染
-                    std::vector<glm::mat4> modelMatrices;
-                    modelMatrices.reserve(instances->size());
-                    for (auto &inst : *instances)
-                    {
-                        modelMatrices.push_back(inst.modelMatrix);
-                    }
-                    mesh->drawInstanced(currentShader, modelMatrices);
-                }
+    // Renderable通常只有几个，按队列做稳定的插入排序
+    for (size_t r = 1; r < renderables.size(); r++)
+    {
+        for (size_t k = r; k > 0 && renderables[k - 1].first > renderables[k].first; k--)
+            std::swap(renderables[k - 1], renderables[k]);
+    }
+    size_t nextRenderable = 0;
+    auto runRenderables = [&](unsigned int beforeQueue)
+    {
+        while (nextRenderable < renderables.size() && renderables[nextRenderable].first <= beforeQueue)
+        {
+            if (inOitPass)
+            {
+                oitPass.End();
+                inOitPass = false;
             }
+            renderables[nextRenderable++].second->Render(viewMatrix, projMatrix, stats);
+            currentShader = nullptr;
+            currentMaterial = nullptr;
+        }
+    };
+
+    for (size_t i = 0; i < count;)
+    {
+        const DrawPacket &packet = packets[items[i].packet];
+        runRenderables(packet.queue);
+        if (packet.oit != inOitPass)
+        {
+            // 切换渲染目标，之后必须重新设置program和材质状态
+            if (packet.oit)
+                oitPass.Begin();
+            else
+                oitPass.End();
+            inOitPass = packet.oit;
+            currentShader = nullptr;
+            currentMaterial = nullptr;
+        }
 
-            bucket.batches.clear();
+        size_t end = i + 1;
+        bool indirect = CanDrawIndirect(packet);
+        if (indirect)
+        {
+            // 同一material、同一几何页的所有绘制合成一次间接绘制
+            while (end < count)
+            {
+                const DrawPacket &next = packets[items[end].packet];
+                if (next.queue != packet.queue || next.material != packet.material ||
+                    next.mesh->geometry.page != packet.mesh->geometry.page || !CanDrawIndirect(next))
+                    break;
+                end++;
+            }
         }
-        else
+        else if (!packet.backToFront)
         {
-            // 透明物体单独处理，按距离摄像机远近排序后再绘制
-            std::vector<std::pair<float, DrawCall>> transparentDrawCallsWithDistance;
-            for (auto &drawCall : bucket.transparentDrawCalls)
+            // 键相同不代表对象相同（id截断），合批时再比较指针
+            while (end < count)
             {
-                glm::vec4 modelPos = glm::vec4(drawCall.modelMatrix[3][0], drawCall.modelMatrix[3][1], drawCall.modelMatrix[3][2], 1.0f);
-                glm::vec4 viewPos = viewMatrix * modelPos;
-                float distance = -viewPos.z; // 负值，越大越远
-                transparentDrawCallsWithDistance.push_back({distance, drawCall});
+                const DrawPacket &next = packets[items[end].packet];
+                if (next.queue != packet.queue || next.material != packet.material || next.mesh != packet.mesh ||
+                    next.lod != packet.lod)
+                    break;
+                end++;
             }
+        }
 
-            std::sort(transparentDrawCallsWithDistance.begin(), transparentDrawCallsWithDistance.end(),
-                      [](const std::pair<float, DrawCall> &a, const std::pair<float, DrawCall> &b)
-                      {
-                          return a.first > b.first; // 从远到近
-                      });
+        Mesh &mesh = *packet.mesh;
+        Material &material = *packet.material;
+        const std::shared_ptr<Shader> &shader = material.GetShader();
+        size_t instances = end - i;
+        ShaderVariant variant = indirect ? ShaderVariant::Indirect
+                                : instances > 1 ? ShaderVariant::Instanced : ShaderVariant::Basic;
 
-            for (auto &[distance, drawCall] : transparentDrawCallsWithDistance)
+        bool programChanged = shader.get() != currentShader || variant != currentVariant;
+        if (programChanged)
+        {
+            shader->Use(variant, inOitPass ? ShaderPass::Oit : ShaderPass::Forward);
+            shader->SetUniformMat4x4f(ID_VIEW, viewMatrix);
+            shader->SetUniformMat4x4f(ID_PROJECTION, projMatrix);
+            currentShader = shader.get();
+            currentVariant = variant;
+            stats.programSwitches++;
+        }
+        if (&material != currentMaterial)
+        {
+            // 材质参数在UBO里，绑定点是全局状态，program切换后不需要重新设置
+            material.ApplyRenderState();
+            if (inOitPass)
+                oitPass.ApplyBlendState(material.renderState.depthWrite);
+            material.ApplyUniforms();
+            currentMaterial = &material;
+            stats.materialSwitches++;
+        }
+
+        if (indirect)
+        {
+            DrawIndirect(material, items + i, instances);
+        }
+        else if (instances == 1)
+        {
+            shader->SetUniformMat4x4f(ID_MODEL, packet.modelMatrix);
+            DrawSingle(mesh, material, shader, packet.modelMatrix, packet.lod);
+        }
+        else
+        {
+            // 实例化渲染：矩阵直接写进持久映射的缓冲区，用base instance指向本批次的起始位置
+            size_t offset = 0;
+            glm::mat4 *dst = (glm::mat4 *)instanceBuffer.Allocate(instances * sizeof(glm::mat4), sizeof(glm::mat4), offset);
+            if (dst)
             {
-                auto &mesh = drawCall.mesh;
-                auto &material = drawCall.material;
-                auto shader = material->GetShader();
-                shader->Use(ShaderVariant::Basic);
-                shader->SetUniformMat4x4f("view", viewMatrix);
-                shader->SetUniformMat4x4f("projection", projMatrix);
-                shader->SetUniformMat4x4f("model", drawCall.modelMatrix);
-
-                material->ApplyRenderState();
-                material->ApplyUniforms();
-
-                mesh->draw(shader);
+                for (size_t k = i; k < end; k++)
+                {
+                    std::memcpy(dst++, &packets[items[k].packet].modelMatrix, sizeof(glm::mat4));
+                }
+                mesh.drawInstanced(shader, instanceBuffer.Buffer(), (unsigned int)(offset / sizeof(glm::mat4)),
+                                   (unsigned int)instances, packet.lod);
+                stats.drawCalls++;
+                stats.trianglesSubmitted += mesh.GetLod(packet.lod).indexCount / 3 * instances;
             }
-
-            bucket.transparentDrawCalls.clear();
         }
+        i = end;
     }
-}
\ No newline at end of file
+    runRenderables(~0u);
+    if (inOitPass)
+        oitPass.End();
+
+    if (packets.size() > packetHighWater || renderables.size() > renderableHighWater)
+    {
+        packetHighWater = std::max(packetHighWater, packets.size());
+        renderableHighWater = std::max(renderableHighWater, renderables.size());
+        RestartAllocationWarmup();
+    }
+    packets.clear();
+    renderables.clear();
+    instanceBuffer.EndFrame();
+    drawDataBuffer.EndFrame();
+    indirectBuffer.EndFrame();
+}
+
+void Renderer::ReportFrameAllocations(size_t allocations)
+{
+    // 前几帧容器/arena/环形缓冲区还在增长，不算
+    static constexpr int WARMUP_FRAMES = 60;
+    // 每次容量增长都会分配一次，警告之间至少间隔这么多帧
+    static constexpr int WARNING_INTERVAL = 300;
+
+    frameCounter++;
+    stats.frameAllocations = allocations;
+    if (allocations == 0 || frameCounter - warmupStart <= WARMUP_FRAMES)
+        return;
+    if (frameCounter - lastAllocationWarning >= WARNING_INTERVAL)
+    {
+        lastAllocationWarning = frameCounter;
+        std::cout << "[Renderer] warning: frame " << frameCounter << " made " << allocations << " heap allocation(s) after warm-up" << std::endl;
+    }
+}
+
+void Renderer::Release()
+{
+    packets.clear();
+    renderables.clear();
+    instanceBuffer.Release();
+    drawDataBuffer.Release();
+    indirectBuffer.Release();
+    oitPass.Release();
+}
@@ -1,8 +1,12 @@
 #pragma once
-#include <map>
 #include <memory>
+#include <cstdint>
 #include "material.h"
 #include "Mesh.h"
+#include "InstanceRingBuffer.h"
+#include "FrameArena.h"
+#include "OitPass.h"
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 struct DrawCall
@@ -10,6 +14,36 @@ struct DrawCall
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Material> material;
     glm::mat4 modelMatrix;
+    int lod = 0; // 见Mesh::lods
+};
+
+// 透明队列的渲染方式
+enum class TransparencyMode
+{
+    Sorted,         // 按物体从远到近排序后逐个混合
+    WeightedBlended // 加权混合OIT，不排序，见OitPass；shader需要提供OIT_PASS版本，否则退回Sorted
+};
+
+// 每帧FlushBatches的统计，下一次FlushBatches开始时清零
+struct RenderStats
+{
+    size_t drawCalls = 0;
+    size_t culledDraws = 0; // 包围盒在视锥外、没有进入排序的提交
+    size_t programSwitches = 0;
+    size_t materialSwitches = 0;
+    size_t trianglesSubmitted = 0;
+    size_t indirectCommands = 0; // 间接绘制命令数（一次glMultiDrawElementsIndirect算一次drawCalls）
+    MeshletCullStats meshlets;
+    size_t frameAllocations = 0; // 上一帧渲染路径上的堆分配次数
+};
+
+// 自己发出绘制命令的对象（例如骨骼可视化），FlushBatches按渲染队列把它插在普通绘制之间执行
+// Render()中可以任意切换program/材质状态，结束后Renderer会重新设置
+class Renderable
+{
+public:
+    virtual ~Renderable() = default;
+    virtual void Render(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix, RenderStats &stats) = 0;
 };
 
 // RenderGraphNode[shader shader;
@@ -28,36 +62,80 @@ struct DrawCall
 
 class Renderer
 {
-    struct RenderInstance
+    // 提交时从DrawCall拷贝，只保存裸指针：mesh/material由场景对象持有，提交到FlushBatches之间一定有效
+    struct DrawPacket
     {
-        glm::mat4 modelMatrix;
+        glm::mat4 modelMatrix; // 放在最前面，与实例属性（3~6号，一个mat4）布局一致
+        Mesh *mesh;
+        Material *material;
+        unsigned int queue;
+        int lod;
+        bool backToFront; // 透明队列按物体排序
+        bool oit;         // 在OIT pass中绘制
     };
 
-    struct BatchKey
+    // 间接绘制的逐绘制数据，std430布局，与*_indirect.shader中的DrawData一致
+    // 着色器用gl_BaseInstance + gl_InstanceID取下标
+    struct DrawData
     {
-        std::shared_ptr<Mesh> mesh;
-        std::shared_ptr<Material> material;
-        bool operator==(const BatchKey &other) const
-        {
-            return mesh == other.mesh && material == other.material;
-        }
+        glm::mat4 modelMatrix;
+        glm::vec4 positionScale;
+        glm::vec4 positionOffset;
     };
 
-    struct BatchKeyHash
+    // glMultiDrawElementsIndirect的命令格式
+    struct DrawElementsIndirectCommand
     {
-        size_t operator()(const BatchKey &key) const noexcept
-        {
-            return std::hash<void *>()(key.mesh.get()) ^ (std::hash<void *>()(key.material.get()) << 1);
-        }
+        unsigned int count;
+        unsigned int instanceCount;
+        unsigned int firstIndex;
+        int baseVertex;
+        unsigned int baseInstance;
     };
 
-    struct RenderQueueBatch
+public:
+    // 排序用的条目，分配在frameArena中
+    struct SortItem
     {
-        std::unordered_map<BatchKey, std::vector<RenderInstance>, BatchKeyHash> batches;
-        std::vector<DrawCall> transparentDrawCalls;
+        uint64_t key;
+        unsigned int packet;
     };
 
-    std::map<int, RenderQueueBatch> renderQueues; // key is RenderQueue enum
+private:
+    std::vector<DrawPacket> packets; // 本帧提交的绘制，clear()保留容量
+    // 本帧提交的Renderable及其渲染队列，与packets的生命周期约定相同
+    std::vector<std::pair<unsigned int, Renderable *>> renderables;
+    FrameArena frameArena;
+
+    RenderStats stats;
+    InstanceRingBuffer instanceBuffer;
+    InstanceRingBuffer drawDataBuffer; // DrawData，每帧整段绑定到DRAW_DATA_BINDING
+    InstanceRingBuffer indirectBuffer; // DrawElementsIndirectCommand
+    bool indirectEnabled = true;
+    OitPass oitPass;
+    std::unordered_map<unsigned int, TransparencyMode> transparencyModes; // 未设置的透明队列为Sorted
+    // 当前帧的相机参数，用于逐簇剔除
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    // 可见簇区间，每帧复用
+    std::vector<IndexRange> visibleRanges;
+
+    int frameCounter = 0;
+    int warmupStart = 0;
+    int lastAllocationWarning = -1000000;
+    // 提交数超过历史最大值时容器还会增长，重新预热
+    size_t packetHighWater = 0;
+    size_t renderableHighWater = 0;
+
+    // 世界空间包围盒做视锥剔除，就地移除不可见的提交
+    void CullPackets();
+    // 单个实例的绘制：LOD0且有簇划分时先做逐簇剔除
+    void DrawSingle(Mesh &mesh, const Material &material, const std::shared_ptr<Shader> &shader,
+                    const glm::mat4 &modelMatrix, int lod);
+    // 不透明队列中shader提供了Indirect变体、mesh已上传到共享页且不需要绑定纹理时走间接绘制
+    bool CanDrawIndirect(const DrawPacket &packet) const;
+    // items中的绘制material和几何页都相同，按mesh/lod分段写入命令，一次glMultiDrawElementsIndirect提交
+    void DrawIndirect(const Material &material, const SortItem *items, size_t count);
 
 public:
     static Renderer &Instance()
@@ -69,6 +147,34 @@ public:
     Renderer &operator=(const Renderer &) = delete;
     Renderer() = default;
 
+    // 64位排序键，按无符号整数升序绘制：
+    //   不透明/OIT: [63..52 渲染队列][51..42 shader][41..30 material][29..14 mesh][13..11 lod][10..0 深度，从近到远]
+    //   排序透明:   [63..52 渲染队列][51..20 深度，从远到近][19..10 shader][9..0 material]
+    // shader/material/mesh取各自的id（见ObjectId.h），超出位宽时截断，只影响合批，不影响正确性
+    // 深度取float的位模式（非负float的位模式与数值同序）
+    static uint64_t MakeSortKey(unsigned int queue, const Shader &shader, const Material &material,
+                                const Mesh &mesh, int lod, float viewDepth, bool backToFront);
+
     void SubmitDrawCall(const DrawCall &drawCall);
+    // 同一队列中先于该队列的普通绘制执行；renderable需保持有效直到FlushBatches返回
+    void SubmitRenderable(Renderable *renderable, unsigned int queue);
     void FlushBatches(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix);
-};
\ No newline at end of file
+    const RenderStats &GetStats() const { return stats; }
+    bool IndirectEnabled() const { return indirectEnabled; }
+    void SetIndirectEnabled(bool enabled) { indirectEnabled = enabled; }
+    // queue须在[Transparent, Overlay)范围内，其他队列总是不混合排序
+    void SetTransparencyMode(unsigned int queue, TransparencyMode mode) { transparencyModes[queue] = mode; }
+    TransparencyMode GetTransparencyMode(unsigned int queue) const;
+    // 记录本帧渲染路径上的堆分配次数（见AllocationCounter），预热之后仍有分配时输出警告
+    void ReportFrameAllocations(size_t allocations);
+    // 新网格上传时调用，按簇数预留逐簇剔除的可见区间数组，避免视角变化后才在绘制中扩容
+    void ReserveMeshletScratch(size_t meshletCount)
+    {
+        if (visibleRanges.capacity() < meshletCount)
+            visibleRanges.reserve(meshletCount);
+    }
+    // 场景内容改变后调用，重新预热一段时间再检查
+    void RestartAllocationWarmup() { warmupStart = frameCounter; }
+    // 释放GL资源，需在GL上下文销毁前调用
+    void Release();
+};
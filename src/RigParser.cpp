@@ -0,0 +1,246 @@
+#include "RigParser.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "MappedFile.h"
+
+void RigData::Clear()
+{
+    names.clear();
+    positions.clear();
+    parents.clear();
+    edges.clear();
+    root = -1;
+    skinVertices.clear();
+    skinOffsets.clear();
+    skinJoints.clear();
+    skinWeights.clear();
+}
+
+namespace
+{
+    // 按空白切分一行
+    struct LineTokenizer
+    {
+        const char *cur;
+        const char *end;
+
+        std::string_view Next()
+        {
+            while (cur < end && (*cur == ' ' || *cur == '\t'))
+                cur++;
+            const char *start = cur;
+            while (cur < end && *cur != ' ' && *cur != '\t')
+                cur++;
+            return std::string_view(start, cur - start);
+        }
+
+        // 旧格式的名字写成<name>，名字中可以有空格，读到对应的'>'为止
+        std::string_view NextName()
+        {
+            while (cur < end && (*cur == ' ' || *cur == '\t'))
+                cur++;
+            if (cur < end && *cur == '<')
+            {
+                const char *close = std::find(cur + 1, end, '>');
+                if (close != end)
+                {
+                    std::string_view name(cur + 1, close - cur - 1);
+                    cur = close + 1;
+                    return name;
+                }
+            }
+            return Next();
+        }
+
+        bool NextFloat(float &value)
+        {
+            std::string_view token = Next();
+            if (!token.empty() && token.front() == '+')
+                token.remove_prefix(1);
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+            return ec == std::errc() && !token.empty();
+        }
+
+        bool NextInt(int &value)
+        {
+            std::string_view token = Next();
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+            return ec == std::errc() && !token.empty();
+        }
+    };
+
+    struct JointTable
+    {
+        RigData &rig;
+        std::unordered_map<std::string_view, int> ids;
+        std::vector<bool> declared; // 是否出现在joints/j记录中
+
+        // 名字第一次出现时分配id（hier可能先于joints出现）
+        int Get(std::string_view name)
+        {
+            auto it = ids.find(name);
+            if (it != ids.end())
+                return it->second;
+
+            int id = (int)rig.names.size();
+            rig.names.emplace_back(name);
+            rig.positions.emplace_back(0.0f);
+            rig.parents.push_back(-1);
+            declared.push_back(false);
+            ids.emplace(name, id);
+            return id;
+        }
+
+        // 去掉只在hier/root/skin中出现、没有位置的名字，以及引用它们的记录
+        // 返回被丢弃的父子关系数
+        size_t DropUndeclared()
+        {
+            std::vector<int> remap(declared.size(), -1);
+            int count = 0;
+            for (size_t id = 0; id < declared.size(); id++)
+            {
+                if (!declared[id])
+                    continue;
+                remap[id] = count;
+                rig.names[count] = std::move(rig.names[id]);
+                rig.positions[count] = rig.positions[id];
+                rig.parents[count] = rig.parents[id];
+                count++;
+            }
+            if (count == (int)declared.size())
+                return 0;
+
+            rig.names.resize(count);
+            rig.positions.resize(count);
+            rig.parents.resize(count);
+            for (int &parent : rig.parents)
+                parent = parent >= 0 ? remap[parent] : -1;
+            rig.root = rig.root >= 0 ? remap[rig.root] : -1;
+
+            size_t edgeCount = rig.edges.size();
+            std::erase_if(rig.edges, [&](std::pair<int, int> &edge)
+                          {
+                              edge = {remap[edge.first], remap[edge.second]};
+                              return edge.first < 0 || edge.second < 0; });
+
+            // skin记录原地压缩，丢掉未声明关节的权重
+            size_t write = 0;
+            for (size_t k = 0; k + 1 < rig.skinOffsets.size(); k++)
+            {
+                uint32_t first = rig.skinOffsets[k];
+                uint32_t last = rig.skinOffsets[k + 1];
+                rig.skinOffsets[k] = (uint32_t)write;
+                for (uint32_t i = first; i < last; i++)
+                {
+                    int joint = remap[rig.skinJoints[i]];
+                    if (joint < 0)
+                        continue;
+                    rig.skinJoints[write] = joint;
+                    rig.skinWeights[write] = rig.skinWeights[i];
+                    write++;
+                }
+            }
+            if (!rig.skinOffsets.empty())
+                rig.skinOffsets.back() = (uint32_t)write;
+            rig.skinJoints.resize(write);
+            rig.skinWeights.resize(write);
+
+            return edgeCount - rig.edges.size();
+        }
+    };
+}
+
+bool RigParser::ParseFile(const std::string &path, RigData &rig)
+{
+    MappedFile file;
+    if (!file.Open(path))
+        return false;
+    const char *begin = (const char *)file.Data();
+    return Parse(begin, begin + file.Size(), rig);
+}
+
+bool RigParser::Parse(const char *begin, const char *end, RigData &rig)
+{
+    rig.Clear();
+    JointTable joints{rig, {}};
+
+    // 粗略按每行约40字节预留，避免哈希表反复rehash
+    size_t estimatedLines = (size_t)(end - begin) / 40 + 16;
+    joints.ids.reserve(estimatedLines);
+    rig.edges.reserve(estimatedLines);
+
+    const char *lineStart = begin;
+    while (lineStart < end)
+    {
+        const char *lineEnd = lineStart;
+        while (lineEnd < end && *lineEnd != '\n')
+            lineEnd++;
+        const char *next = lineEnd + 1;
+        if (lineEnd > lineStart && lineEnd[-1] == '\r')
+            lineEnd--;
+
+        LineTokenizer line{lineStart, lineEnd};
+        std::string_view type = line.Next();
+
+        if (type == "joints" || type == "j")
+        {
+            std::string_view name = type == "j" ? line.NextName() : line.Next();
+            glm::vec3 p;
+            if (!name.empty() && line.NextFloat(p.x) && line.NextFloat(p.y) && line.NextFloat(p.z))
+            {
+                int id = joints.Get(name);
+                rig.positions[id] = p;
+                joints.declared[id] = true;
+            }
+        }
+        else if (type == "hier" || type == "e")
+        {
+            std::string_view parentName = type == "e" ? line.NextName() : line.Next();
+            std::string_view childName = type == "e" ? line.NextName() : line.Next();
+            if (!parentName.empty() && !childName.empty())
+            {
+                int parent = joints.Get(parentName);
+                int child = joints.Get(childName);
+                rig.parents[child] = parent;
+                rig.edges.emplace_back(parent, child);
+            }
+        }
+        else if (type == "root")
+        {
+            std::string_view name = line.Next();
+            if (!name.empty())
+                rig.root = joints.Get(name);
+        }
+        else if (type == "skin")
+        {
+            int vertex;
+            if (line.NextInt(vertex))
+            {
+                if (rig.skinOffsets.empty())
+                    rig.skinOffsets.push_back(0);
+                rig.skinVertices.push_back(vertex);
+                while (true)
+                {
+                    std::string_view name = line.Next();
+                    float weight;
+                    if (name.empty() || !line.NextFloat(weight))
+                        break;
+                    rig.skinJoints.push_back(joints.Get(name));
+                    rig.skinWeights.push_back(weight);
+                }
+                rig.skinOffsets.push_back((uint32_t)rig.skinJoints.size());
+            }
+        }
+
+        lineStart = next;
+    }
+
+    size_t droppedEdges = joints.DropUndeclared();
+    if (droppedEdges > 0)
+        std::cout << "[RigParser] skipped " << droppedEdges << " hier records referencing undeclared joints" << std::endl;
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// rig文件解析结果，关节用整数id表示，全部存放在连续数组中
+struct RigData
+{
+    std::vector<std::string> names;     // id -> 关节名
+    std::vector<glm::vec3> positions;   // id -> 关节位置
+    std::vector<int> parents;           // id -> 父关节id，没有父关节为-1
+    std::vector<std::pair<int, int>> edges; // (parent, child)
+    int root = -1;
+
+    // skin记录: 顶点skinVertices[k]受 skinJoints/skinWeights[skinOffsets[k], skinOffsets[k+1]) 影响
+    std::vector<int> skinVertices;
+    std::vector<uint32_t> skinOffsets;
+    std::vector<int> skinJoints;
+    std::vector<float> skinWeights;
+
+    int JointCount() const { return (int)names.size(); }
+    void Clear();
+};
+
+// RigNet骨骼文件的单遍解析器（不使用std::regex），支持以下记录：
+//   joints <name> x y z         关节位置
+//   hier <parent> <child>       父子关系
+//   root <name>                 根关节
+//   skin <vid> <name> w ...     顶点蒙皮权重
+//   j <name> x y z / e <parent> <child>  旧格式，名字带尖括号
+// 无法识别的行会被跳过；没有joints记录的名字不会成为关节，引用它们的hier/skin记录被丢弃
+class RigParser
+{
+public:
+    // 内存映射文件后解析
+    static bool ParseFile(const std::string &path, RigData &rig);
+    // 解析一段内存
+    static bool Parse(const char *begin, const char *end, RigData &rig);
+};
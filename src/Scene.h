@@ -1,31 +1,36 @@
-#pragma once
-
 #pragma once
 #include <vector>
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <typeindex>
+#include <iostream>
 
 #include "Camera.h"
 #include "SceneObject.h"
 #include "LightManager.h"
 
+// 场景对象存放在SlotMap中，用SceneHandle寻址，查找和删除都是O(1)
+// 另外按具体类型维护紧密列表，可以只遍历某一类对象；名字只用于按名字查找
 class Scene
 {
 public:
     LightManager lightManager;
 
-    // 添加对象（注册进场景）
-    void AddSceneObject(const std::shared_ptr<SceneObject> &obj)
+    // 添加对象（注册进场景），重名或已在场景中时返回无效句柄
+    SceneHandle AddSceneObject(const std::shared_ptr<SceneObject> &obj)
     {
-        if (!obj)
-            return;
+        if (!obj || objects.Contains(obj->handle))
+            return {};
 
-        if (sceneObjectMap.find(obj->objName) != sceneObjectMap.end())
-            return;
+        if (nameToHandle.find(obj->objName) != nameToHandle.end())
+            return {};
 
-        sceneObjects.push_back(obj);
-        sceneObjectMap[obj->objName] = obj;
+        SceneObject &ref = *obj;
+        std::vector<SceneObjectRef> &typeList = typeLists[std::type_index(typeid(ref))];
+        obj->handle = objects.Insert({obj, std::type_index(typeid(ref)), (uint32_t)typeList.size()});
+        typeList.push_back({obj.get(), obj->handle});
+        nameToHandle[obj->objName] = obj->handle;
         // std::cout << "Added " << "<" << obj->className << ">" << obj->objName << std::endl;
 
         auto lightPtr = std::dynamic_pointer_cast<Light>(obj);
@@ -33,76 +38,126 @@ public:
         {
             lightManager.AddLight(lightPtr);
         }
+        return obj->handle;
     }
 
-    // 通过名字查找对象
+    // 通过句柄查找对象，类型不符或句柄失效时返回nullptr
     template <typename T>
-    std::shared_ptr<T> GetObject(const std::string &name)
+    std::shared_ptr<T> GetObject(SceneHandle handle)
     {
         static_assert(std::is_base_of_v<SceneObject, T>, "T must derive from SceneObject");
 
-        auto it = sceneObjectMap.find(name);
-        if (it == sceneObjectMap.end())
+        Entry *entry = objects.Get(handle);
+        if (!entry)
             return nullptr;
+        // 具体类型相同时不需要dynamic_cast
+        if (entry->type == std::type_index(typeid(T)))
+            return std::static_pointer_cast<T>(entry->object);
+        return std::dynamic_pointer_cast<T>(entry->object);
+    }
 
-        auto basePtr = it->second.lock();
-        if (!basePtr)
+    // 通过名字查找对象
+    template <typename T>
+    std::shared_ptr<T> GetObject(const std::string &name)
+    {
+        auto it = nameToHandle.find(name);
+        if (it == nameToHandle.end())
             return nullptr;
-
-        return std::dynamic_pointer_cast<T>(basePtr);
+        return GetObject<T>(it->second);
     }
 
-    // 移除对象和它的子对象
-    void Remove(const std::string &name)
+    // 移除对象和它的子对象：先收集整棵子树，再逐个O(1)删除
+    void Remove(SceneHandle handle)
     {
-        auto it = sceneObjectMap.find(name);
-        if (it != sceneObjectMap.end())
+        Entry *entry = objects.Get(handle);
+        if (!entry)
+            return;
+        std::shared_ptr<SceneObject> target = entry->object;
+
+        // 持有引用直到全部删除完，父对象析构时子对象仍然有效
+        removeQueue.clear();
+        removeQueue.push_back(target);
+        for (size_t i = 0; i < removeQueue.size(); i++)
         {
-            auto target = it->second.lock();
-            if (target)
+            for (auto &child : removeQueue[i]->children)
+                removeQueue.push_back(child);
+        }
+
+        for (auto &obj : removeQueue)
+        {
+            Entry *removed = objects.Get(obj->handle);
+            if (!removed)
+                continue;
+
+            // 从类型列表中换尾删除
+            std::vector<SceneObjectRef> &typeList = typeLists[removed->type];
+            uint32_t typeSlot = removed->typeSlot;
+            if (typeSlot + 1 != typeList.size())
+            {
+                typeList[typeSlot] = typeList.back();
+                objects.Get(typeList[typeSlot].handle)->typeSlot = typeSlot;
+            }
+            typeList.pop_back();
+
+            auto lightPtr = std::dynamic_pointer_cast<Light>(removed->object);
+            if (lightPtr)
             {
-                for (auto &child : target->children)
-                {
-                    Remove(child->objName);
-                }
-                sceneObjects.erase(
-                    std::remove_if(sceneObjects.begin(), sceneObjects.end(),
-                                   [&](auto &o)
-                                   { return o == target; }),
-                    sceneObjects.end());
-
-                auto lightPtr = std::dynamic_pointer_cast<Light>(target);
-                if (lightPtr)
-                {
-                    lightManager.RemoveLight(lightPtr);
-                }
+                lightManager.RemoveLight(lightPtr);
             }
-            sceneObjectMap.erase(it);
-            std::cout << "Removed " << "<" << target->className << ">" << name << std::endl;
+
+            auto it = nameToHandle.find(obj->objName);
+            if (it != nameToHandle.end() && it->second == obj->handle)
+                nameToHandle.erase(it);
+            objects.Remove(obj->handle);
+            obj->handle = {};
         }
+        std::cout << "Removed " << "<" << target->className << ">" << target->objName << " (" << removeQueue.size()
+                  << " objects)" << std::endl;
+        removeQueue.clear();
     }
 
-    // 调用所有对象的更新与绘制
+    void Remove(const std::string &name)
+    {
+        auto it = nameToHandle.find(name);
+        if (it != nameToHandle.end())
+            Remove(it->second);
+    }
+
+    // 执行已注册的系统（见SceneSystem），只遍历有系统的类型，没有对象的系统跳过
     void UpdateAll()
     {
-        for (auto &obj : sceneObjects)
+        systemBatches.clear();
+        for (const SceneSystem &system : SceneSystem::Registry())
         {
-            if (obj && obj->active)
-                obj->update();
+            auto it = typeLists.find(system.type);
+            if (it != typeLists.end() && !it->second.empty())
+                systemBatches.push_back({&system, it->second.data(), it->second.size()});
         }
+        RunSceneSystems(systemBatches, systemHandles);
     }
 
     void DrawAll()
     {
-        for (auto &obj : sceneObjects)
+        for (size_t i = 0; i < objects.Size(); i++)
         {
-            if (obj && obj->active)
+            SceneObject *obj = objects.At(i).object.get();
+            if (obj->active)
                 obj->draw();
         }
     }
 
-    // 获取所有对象
-    const std::vector<std::shared_ptr<SceneObject>> &GetObjects() const { return sceneObjects; }
+    size_t ObjectCount() const { return objects.Size(); }
+
+    // 遍历某一具体类型的所有对象（不包含派生类型）
+    template <typename T, typename Func>
+    void ForEach(Func &&func)
+    {
+        auto it = typeLists.find(std::type_index(typeid(T)));
+        if (it == typeLists.end())
+            return;
+        for (const SceneObjectRef &typed : it->second)
+            func(*static_cast<T *>(typed.object));
+    }
 
     // 设置主相机
     void SetMainCamera(const std::shared_ptr<Camera> &camera)
@@ -116,7 +171,18 @@ public:
     }
 
 private:
-    std::vector<std::shared_ptr<SceneObject>> sceneObjects;
-    std::unordered_map<std::string, std::weak_ptr<SceneObject>> sceneObjectMap;
+    struct Entry
+    {
+        std::shared_ptr<SceneObject> object;
+        std::type_index type;
+        uint32_t typeSlot; // 在typeLists[type]中的位置
+    };
+    SlotMap<Entry> objects;
+    std::unordered_map<std::type_index, std::vector<SceneObjectRef>> typeLists;
+    std::unordered_map<std::string, SceneHandle> nameToHandle;
+    std::vector<std::shared_ptr<SceneObject>> removeQueue;
+    // UpdateAll的临时数组
+    std::vector<SceneSystemBatch> systemBatches;
+    std::vector<JobHandle> systemHandles;
     std::shared_ptr<Camera> mainCamera;
 };
@@ -16,10 +16,19 @@ public:
     }
 
     // 以下封装直接代理给 currentScene
-    static void AddObject(const std::shared_ptr<SceneObject> &obj)
+    static SceneHandle AddObject(const std::shared_ptr<SceneObject> &obj)
     {
         if (currentScene)
-            currentScene->AddSceneObject(obj);
+            return currentScene->AddSceneObject(obj);
+        return {};
+    }
+
+    template <typename T>
+    static std::shared_ptr<T> GetObject(SceneHandle handle)
+    {
+        if (!currentScene)
+            return nullptr;
+        return currentScene->GetObject<T>(handle);
     }
 
     template <typename T>
@@ -42,6 +51,12 @@ public:
             currentScene->DrawAll();
     }
 
+    static void Remove(SceneHandle handle)
+    {
+        if (currentScene)
+            currentScene->Remove(handle);
+    }
+
     static void Remove(const std::string &name)
     {
         if (currentScene)
@@ -6,6 +6,10 @@
 #include <functional>
 #include <memory>
 #include "Transform.h"
+#include "SlotMap.h"
+#include "SceneSystem.h"
+
+using SceneHandle = SlotHandle;
 
 #define REGISTER_SCENE_OBJECT(Derived)                                                        \
     struct Derived##Factory                                                                   \
@@ -49,13 +53,21 @@ struct SceneObject
     Transform transform;
     bool active = true;
     std::vector<std::shared_ptr<SceneObject>> children;
+    SceneHandle handle; // 加入场景后由Scene设置，移除后失效
 
     SceneObject() : transform() {}
     virtual ~SceneObject() = default;
 
     virtual void awake() {}
+    // 只有用REGISTER_SCENE_SYSTEM注册过的类型会在Scene::UpdateAll中被调用
     virtual void update() {}
     virtual void draw() {}
+    // 加入children，并让child的transform相对本对象
+    void AddChild(const std::shared_ptr<SceneObject> &child)
+    {
+        child->transform.parent(&transform);
+        children.push_back(child);
+    }
     virtual void SetActive(bool isActive)
     {
         active = isActive;
@@ -0,0 +1,56 @@
+#include "SceneSystem.h"
+#include <algorithm>
+
+void SceneSystem::Register(SceneSystem system)
+{
+    // 静态初始化顺序不确定，按(order, name)插入保证冲突系统的执行顺序固定
+    std::vector<SceneSystem> &systems = registry();
+    auto position = std::upper_bound(systems.begin(), systems.end(), system,
+                                     [](const SceneSystem &a, const SceneSystem &b)
+                                     { return a.order != b.order ? a.order < b.order : a.name < b.name; });
+    systems.insert(position, std::move(system));
+}
+
+void SceneSystemBatch::Execute() const
+{
+    if (system->grain > 0 && system->affinity != JobAffinity::MainThread && count > system->grain)
+    {
+        JobSystem::Instance().ParallelFor(0, count, system->grain, [this](size_t begin, size_t end)
+                                          { system->update(objects + begin, end - begin); });
+        return;
+    }
+    system->update(objects, count);
+}
+
+void RunSceneSystems(const std::vector<SceneSystemBatch> &batches, std::vector<JobHandle> &handles)
+{
+    if (batches.empty())
+        return;
+    // 只有一个系统时直接在主线程执行
+    if (batches.size() == 1)
+    {
+        batches[0].Execute();
+        return;
+    }
+
+    JobSystem &jobSystem = JobSystem::Instance();
+    JobHandle root = jobSystem.Create([] {});
+    handles.clear();
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        const SceneSystemBatch *batch = &batches[i];
+        JobHandle handle = jobSystem.Create([batch]
+                                            { batch->Execute(); },
+                                            root, batch->system->affinity);
+        // 前面的系统都已经Run()，依赖的任务已在执行或已完成
+        for (size_t j = 0; j < i; j++)
+        {
+            if (batches[j].system->ConflictsWith(*batch->system))
+                jobSystem.AddDependency(handle, handles[j]);
+        }
+        jobSystem.Run(handle);
+        handles.push_back(handle);
+    }
+    jobSystem.Run(root);
+    jobSystem.Wait(root);
+}
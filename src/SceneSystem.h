@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SlotMap.h"
+
+struct SceneObject;
+
+// Scene按具体类型存放的对象引用
+struct SceneObjectRef
+{
+    SceneObject *object;
+    SlotHandle handle;
+};
+
+// 系统读写的数据，用于判断两个系统能否同时执行
+enum SceneResource : uint32_t
+{
+    RESOURCE_TRANSFORMS = 1 << 0,         // TransformStore中的分量（setter可并发调用，SetParent除外）
+    RESOURCE_INPUT = 1 << 1,              // Input的按键和鼠标状态
+    RESOURCE_SKELETON_INSTANCES = 1 << 2, // Skeleton的CPU端实例数组
+};
+
+// 更新阶段的一个系统：每帧对某一具体类型的所有活动对象调用一次非虚的update()
+// 只有注册了系统的类型会被遍历，update()为空的类型（如Model）不产生任何开销
+// 读写集合不相交的系统并行执行；冲突的系统按order（相同时按名字）先后执行
+// 系统中不能添加或删除场景对象，也不能调用Transform::parent()
+struct SceneSystem
+{
+    // 一次处理objects[0, count)
+    using UpdateFunc = void (*)(const SceneObjectRef *objects, size_t count);
+
+    std::string name;
+    std::type_index type = typeid(void);
+    int order = 0;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    // MainThread用于需要GL或窗口输入的系统
+    JobAffinity affinity = JobAffinity::Any;
+    // 大于0时对象按grain个一块并行更新；MainThread系统忽略
+    size_t grain = 0;
+    UpdateFunc update = nullptr;
+
+    bool ConflictsWith(const SceneSystem &other) const
+    {
+        return (writes & (other.reads | other.writes)) || (other.writes & reads);
+    }
+
+    template <typename T>
+    static SceneSystem ForUpdate(const char *name, int order, uint32_t reads, uint32_t writes,
+                                 JobAffinity affinity, size_t grain)
+    {
+        return {name, typeid(T), order, reads, writes, affinity, grain,
+                [](const SceneObjectRef *objects, size_t count)
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        T *object = static_cast<T *>(objects[i].object);
+                        if (object->active)
+                            object->T::update();
+                    }
+                }};
+    }
+
+    // 按(order, name)排序
+    static const std::vector<SceneSystem> &Registry() { return registry(); }
+    static void Register(SceneSystem system);
+
+private:
+    static std::vector<SceneSystem> &registry()
+    {
+        static std::vector<SceneSystem> impl;
+        return impl;
+    }
+};
+
+// 一帧中要执行的系统和它的对象
+struct SceneSystemBatch
+{
+    const SceneSystem *system;
+    const SceneObjectRef *objects;
+    size_t count;
+
+    void Execute() const;
+};
+
+// 在主线程调用：按读写冲突建立任务图，交给JobSystem执行，返回时全部完成
+// handles为调用方保存的临时数组，避免每帧分配
+void RunSceneSystems(const std::vector<SceneSystemBatch> &batches, std::vector<JobHandle> &handles);
+
+// 在类定义中使用，把T::update()注册为系统
+#define REGISTER_SCENE_SYSTEM(Derived, Order, Reads, Writes, Affinity, Grain)                              \
+    struct Derived##SystemRegistrar                                                                         \
+    {                                                                                                       \
+        Derived##SystemRegistrar()                                                                          \
+        {                                                                                                   \
+            SceneSystem::Register(SceneSystem::ForUpdate<Derived>(#Derived, Order, Reads, Writes, Affinity, \
+                                                                  Grain));                                  \
+        }                                                                                                   \
+    };                                                                                                      \
+    static inline Derived##SystemRegistrar global_##Derived##SystemRegistrar;
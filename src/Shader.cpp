@@ -1,52 +1,15 @@
 #include <GL/glew.h>
 #include "Shader.h"
+#include "GLState.h"
 #include <cassert>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 #include <string>
 #include <fstream>
-#include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-static std::unordered_map<std::string, std::function<void(int, const std::any &)>> uniformSetters = {
-    {"int", [](int loc, const std::any &value)
-     {
-         glUniform1i(loc, std::any_cast<int>(value));
-     }},
-    {"uint", [](int loc, const std::any &value)
-     {
-         glUniform1ui(loc, std::any_cast<unsigned int>(value));
-     }},
-    {"float", [](int loc, const std::any &value)
-     {
-         glUniform1f(loc, std::any_cast<float>(value));
-     }},
-    {"vec3f", [](int loc, const std::any &value)
-     {
-         const glm::vec3 &v = std::any_cast<glm::vec3>(value);
-         glUniform3fv(loc, 1, glm::value_ptr(v));
-     }},
-    {"vec4f", [](int loc, const std::any &value)
-     {
-         const glm::vec4 &v = std::any_cast<glm::vec4>(value);
-         glUniform4fv(loc, 1, glm::value_ptr(v));
-     }},
-    {"vec3i", [](int loc, const std::any &value)
-     {
-         const glm::ivec3 &v = std::any_cast<glm::ivec3>(value);
-         glUniform3iv(loc, 1, glm::value_ptr(v));
-     }},
-    {"vec4i", [](int loc, const std::any &value)
-     {
-         const glm::ivec4 &v = std::any_cast<glm::ivec4>(value);
-         glUniform4iv(loc, 1, glm::value_ptr(v));
-     }},
-    {"mat4", [](int loc, const std::any &value)
-     {
-         const glm::mat4 &m = std::any_cast<glm::mat4>(value);
-         glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(m));
-     }}};
-
 ShaderSourceString Shader::PraseShaderSource(const std::string &file)
 {
     std::ifstream source(file);
@@ -116,16 +79,150 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string &shader_
     return shader;
 }
 
-int Shader::getUniformLocation(const std::string &label)
+void Shader::Reflect(ShaderProgram &program)
 {
-    int loc = glGetUniformLocation(currentProgram, label.c_str());
-    if (loc == -1)
+    auto add = [&](std::unordered_map<uint32_t, int> &table, const std::string &name, int value)
     {
-        std::cout << "get uniform location fail: \"" << label << "\"" << std::endl;
-        return -1;
+        uint32_t id = PropertyToID(name);
+        auto [it, inserted] = program.names.emplace(id, name);
+        if (!inserted && it->second != name)
+        {
+            std::cout << "uniform name hash collision: \"" << name << "\" and \"" << it->second << "\"" << std::endl;
+        }
+        table[id] = value;
+    };
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(std::max(maxLength, 1), '\0');
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program.id, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+        std::string uniform(name.data(), length);
+        int location = glGetUniformLocation(program.id, uniform.c_str());
+        // uniform block中的成员没有location
+        if (location < 0)
+            continue;
+        add(program.uniforms, uniform, location);
+        // 数组"xxx[0]"同时注册为"xxx"
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+        {
+            add(program.uniforms, uniform.substr(0, uniform.size() - 3), location);
+        }
     }
-    // std::cout << "\"" << label << "\" location: " << loc << std::endl;
-    return loc;
+
+    GLint blockCount = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.assign(std::max(maxLength, 1), '\0');
+    for (GLint i = 0; i < blockCount; i++)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program.id, (GLuint)i, (GLsizei)name.size(), &length, name.data());
+        std::string blockName(name.data(), length);
+        uint32_t id = PropertyToID(blockName);
+        program.blocks[id] = (unsigned int)i;
+        program.names.emplace(id, blockName);
+        if (blockName == "MaterialBlock")
+        {
+            glUniformBlockBinding(program.id, (GLuint)i, MATERIAL_BINDING);
+        }
+
+        // 成员的std140偏移和类型
+        UniformBlockLayout &layout = program.blockLayouts[id];
+        GLint dataSize = 0, memberCount = 0;
+        glGetActiveUniformBlockiv(program.id, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+        glGetActiveUniformBlockiv(program.id, (GLuint)i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+        layout.size = (unsigned int)dataSize;
+        if (memberCount <= 0)
+            continue;
+
+        std::vector<GLint> indices(memberCount);
+        glGetActiveUniformBlockiv(program.id, (GLuint)i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+        std::vector<GLuint> uniformIndices(indices.begin(), indices.end());
+        std::vector<GLint> offsets(memberCount), types(memberCount);
+        glGetActiveUniformsiv(program.id, memberCount, uniformIndices.data(), GL_UNIFORM_OFFSET, offsets.data());
+        glGetActiveUniformsiv(program.id, memberCount, uniformIndices.data(), GL_UNIFORM_TYPE, types.data());
+
+        GLint memberMaxLength = 0;
+        glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &memberMaxLength);
+        std::string memberName(std::max(memberMaxLength, 1), '\0');
+        for (GLint m = 0; m < memberCount; m++)
+        {
+            GLsizei memberLength = 0;
+            glGetActiveUniformName(program.id, uniformIndices[m], (GLsizei)memberName.size(), &memberLength, memberName.data());
+            std::string_view member(memberName.data(), memberLength);
+            // 有实例名的block成员形如"Block.member"，数组形如"member[0]"
+            if (size_t dot = member.rfind('.'); dot != std::string_view::npos)
+                member.remove_prefix(dot + 1);
+            if (member.size() > 3 && member.substr(member.size() - 3) == "[0]")
+                member.remove_suffix(3);
+            layout.members[PropertyToID(member)] = {(unsigned int)offsets[m], (unsigned int)types[m]};
+        }
+    }
+}
+
+const UniformBlockLayout *Shader::GetBlockLayout(uint32_t blockId) const
+{
+    auto program = programs.find(ProgramKey(ShaderVariant::Basic, ShaderPass::Forward));
+    if (program == programs.end())
+        return nullptr;
+    auto it = program->second.blockLayouts.find(blockId);
+    return it != program->second.blockLayouts.end() ? &it->second : nullptr;
+}
+
+int Shader::GetUniformLocation(uint32_t id)
+{
+    if (current)
+    {
+        auto it = current->uniforms.find(id);
+        if (it != current->uniforms.end())
+            return it->second;
+    }
+
+    // 被编译器优化掉或者名字写错的uniform，每个program只提示一次
+    if (warnedMissing.insert(((uint64_t)currentProgram << 32) | id).second)
+    {
+        std::cout << "get uniform location fail: id " << id << " in program " << currentProgram << std::endl;
+    }
+    return -1;
+}
+
+int Shader::GetUniformBlockIndex(uint32_t id) const
+{
+    if (!current)
+        return -1;
+    auto it = current->blocks.find(id);
+    return it != current->blocks.end() ? (int)it->second : -1;
+}
+
+// 在#version之后插入宏定义
+static std::string InsertDefine(const std::string &source, const char *define)
+{
+    size_t lineEnd = source.find('\n', source.find("#version"));
+    if (lineEnd == std::string::npos)
+        return source;
+    return source.substr(0, lineEnd + 1) + "#define " + define + "\n" + source.substr(lineEnd + 1);
+}
+
+unsigned int Shader::LinkProgram(const ShaderSourceString &source)
+{
+    int program = glCreateProgram();
+    unsigned int vertex_shader = CompileShader(GL_VERTEX_SHADER, source.vertex_source);
+    unsigned int fragment_shader = CompileShader(GL_FRAGMENT_SHADER, source.fragment_source);
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);     // link the two shader together
+    glValidateProgram(program); // validate the program
+
+    glDeleteShader(vertex_shader); // now we don't need the shader object
+    glDeleteShader(fragment_shader);
+    return program;
 }
 
 Shader::Shader(const std::unordered_map<ShaderVariant, std::string> &shaderpaths)
@@ -134,21 +231,27 @@ Shader::Shader(const std::unordered_map<ShaderVariant, std::string> &shaderpaths
     {
         ShaderSourceString ss = PraseShaderSource(path);
 
-        int program = glCreateProgram();
-        unsigned int vertex_shader = CompileShader(GL_VERTEX_SHADER, ss.vertex_source);
-        unsigned int fragment_shader = CompileShader(GL_FRAGMENT_SHADER, ss.fragment_source);
-
-        glAttachShader(program, vertex_shader);
-        glAttachShader(program, fragment_shader);
-        glLinkProgram(program);     // link the two shader together
-        glValidateProgram(program); // validate the program
-
-        glDeleteShader(vertex_shader); // now we don't need the shader object
-        glDeleteShader(fragment_shader);
+        ShaderProgram &info = programs[ProgramKey(variant, ShaderPass::Forward)];
+        info.id = LinkProgram(ss);
+        Reflect(info);
 
-        programs[variant] = program;
+        if (ss.fragment_source.find("OIT_PASS") != std::string::npos)
+        {
+            ShaderSourceString oit = {InsertDefine(ss.vertex_source, "OIT_PASS"),
+                                      InsertDefine(ss.fragment_source, "OIT_PASS")};
+            ShaderProgram &oitInfo = programs[ProgramKey(variant, ShaderPass::Oit)];
+            oitInfo.id = LinkProgram(oit);
+            Reflect(oitInfo);
+        }
+    }
+    auto basic = programs.find(ProgramKey(ShaderVariant::Basic, ShaderPass::Forward));
+    if (basic == programs.end())
+    {
+        std::cout << "[Shader] warning: no Basic variant, using another variant as default" << std::endl;
+        basic = programs.begin();
     }
-    currentProgram = programs.at(ShaderVariant::Basic);
+    current = basic != programs.end() ? &basic->second : nullptr;
+    currentProgram = current ? current->id : 0;
 }
 
 Shader::~Shader()
@@ -156,82 +259,80 @@ Shader::~Shader()
     Delete();
 }
 
-void Shader::Use(ShaderVariant variant)
+void Shader::Use(ShaderVariant variant, ShaderPass pass)
 {
-    currentProgram = programs[variant];
-    glUseProgram(currentProgram);
+    uint32_t key = ProgramKey(variant, pass);
+    auto it = programs.find(key);
+    if (it == programs.end())
+    {
+        if (warnedMissingPrograms.insert(key).second)
+            std::cout << "[Shader] warning: variant " << (int)variant << " pass " << (int)pass
+                      << " was not compiled, falling back" << std::endl;
+        it = programs.find(ProgramKey(variant, ShaderPass::Forward));
+        if (it == programs.end())
+            it = programs.find(ProgramKey(ShaderVariant::Basic, ShaderPass::Forward));
+        if (it == programs.end())
+            return;
+    }
+    current = &it->second;
+    currentProgram = current->id;
+    GLState::Instance().UseProgram(currentProgram);
 }
 
 void Shader::Delete()
 {
     for (auto var : programs)
-        glDeleteProgram(var.second);
+    {
+        GLState::Instance().ForgetProgram(var.second.id);
+        glDeleteProgram(var.second.id);
+    }
 }
 
-void Shader::SetUniform1f(const std::string &label, float v)
+void Shader::SetUniform1f(uint32_t id, float v)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform1f(loc, v);
 }
 
-void Shader::SetUniform1i(const std::string &label, int v)
+void Shader::SetUniform1i(uint32_t id, int v)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform1i(loc, v);
 }
 
-void Shader::SetUniformVec3f(const std::string &label, float v1, float v2, float v3)
+void Shader::SetUniformVec3f(uint32_t id, float v1, float v2, float v3)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform3f(loc, v1, v2, v3);
 }
 
-void Shader::SetUniformVec3i(const std::string &label, int v1, int v2, int v3)
+void Shader::SetUniformVec3i(uint32_t id, int v1, int v2, int v3)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform3i(loc, v1, v2, v3);
 }
 
-void Shader::SetUniformVec4f(const std::string &label, float v1, float v2, float v3, float v4)
+void Shader::SetUniformVec4f(uint32_t id, float v1, float v2, float v3, float v4)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform4f(loc, v1, v2, v3, v4);
 }
 
-void Shader::SetUniformVec4i(const std::string &label, int v1, int v2, int v3, int v4)
+void Shader::SetUniformVec4i(uint32_t id, int v1, int v2, int v3, int v4)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniform4i(loc, v1, v2, v3, v4);
 }
 
-void Shader::SetUniformMat4x4f(const std::string &label, const glm::mat4 &mat)
+void Shader::SetUniformMat4x4f(uint32_t id, const glm::mat4 &mat)
 {
-    int loc = getUniformLocation(label);
+    int loc = GetUniformLocation(id);
     if (loc >= 0)
         glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
 }
-
-void Shader::SetUniforms(const std::unordered_map<std::string, std::pair<std::string, std::any>> &uniforms)
-{
-    glUseProgram(currentProgram);
-    for (const auto &[name, typeAndValue] : uniforms)
-    {
-        const auto &[type, value] = typeAndValue;
-        auto loc = getUniformLocation(name);
-        auto it = uniformSetters.find(type);
-        if (it != uniformSetters.end())
-        {
-            it->second(loc, value);
-        }
-        else
-        {
-            std::cerr << "Error: unknown uniform type '" << type << "' for " << name << "\n";
-        }
-    }
-}
@@ -6,8 +6,11 @@
 #include "config.h"
 #include <fstream>
 #include <unordered_map>
-#include <any>
+#include <unordered_set>
+#include <string_view>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include "ObjectId.h"
 
 struct ShaderSourceString
 {
@@ -19,35 +22,122 @@ enum class ShaderVariant
 {
     Basic,
     Instanced,
-    Shadow
+    Shadow,
+    Indirect // 逐绘制数据来自SSBO，用glMultiDrawElementsIndirect提交，见Renderer
+};
+
+// 同一个shader变体在不同渲染pass中的版本
+// Oit：源码中出现OIT_PASS时，额外以 #define OIT_PASS 编译一份，输出到加权混合OIT的累积/透明度目标
+enum class ShaderPass
+{
+    Forward,
+    Oit
+};
+
+// uniform block的绑定点：0 灯光（LightManager），1 材质参数（Material）
+enum UniformBinding : unsigned int
+{
+    LIGHT_BINDING = 0,
+    MATERIAL_BINDING = 1
+};
+
+// shader storage block的绑定点：0 间接绘制的逐绘制数据（Renderer），1 骨骼可视化的实例数据（Skeleton）
+enum StorageBinding : unsigned int
+{
+    DRAW_DATA_BINDING = 0,
+    SKELETON_BINDING = 1
+};
+
+// std140 uniform block中一个成员的偏移和GL类型（如GL_FLOAT_VEC4）
+struct UniformBlockMember
+{
+    unsigned int offset;
+    unsigned int type;
+};
+
+struct UniformBlockLayout
+{
+    unsigned int size = 0;
+    std::unordered_map<uint32_t, UniformBlockMember> members; // PropertyToID(成员名) ->
+};
+
+// 链接后反射得到的program信息，uniform/uniform block都按PropertyToID(name)索引
+struct ShaderProgram
+{
+    unsigned int id = 0;
+    std::unordered_map<uint32_t, int> uniforms;         // -> location
+    std::unordered_map<uint32_t, unsigned int> blocks;  // -> uniform block index
+    std::unordered_map<uint32_t, UniformBlockLayout> blockLayouts;
+    std::unordered_map<uint32_t, std::string> names;    // 用于警告信息
 };
 
 class Shader
 {
-    std::unordered_map<ShaderVariant, unsigned int> programs;
+    // 键为ProgramKey(variant, pass)
+    std::unordered_map<uint32_t, ShaderProgram> programs;
+    ShaderProgram *current = nullptr;
     unsigned int currentProgram = 0;
+    // 已经警告过的缺失uniform：(program << 32) | id
+    std::unordered_set<uint64_t> warnedMissing;
+    // 已经警告过的未编译program：ProgramKey
+    std::unordered_set<uint32_t> warnedMissingPrograms;
 
     ShaderSourceString PraseShaderSource(const std::string &file);
     unsigned int CompileShader(unsigned int type, const std::string &shader_source);
-
-    int getUniformLocation(const std::string &label);
+    static void Reflect(ShaderProgram &program);
+    unsigned int LinkProgram(const ShaderSourceString &source);
+    static uint32_t ProgramKey(ShaderVariant variant, ShaderPass pass) { return (uint32_t)variant | (uint32_t)pass << 8; }
 
 public:
+    // 名字的FNV-1a哈希，编译期可用，热路径上用预先算好的ID代替字符串：
+    //   static constexpr uint32_t ID_MODEL = Shader::PropertyToID("model");
+    static constexpr uint32_t PropertyToID(std::string_view name)
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : name)
+        {
+            hash ^= (unsigned char)c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    const unsigned int id = NextObjectId<Shader>(); // 见Renderer的排序键
+
     Shader(const std::unordered_map<ShaderVariant, std::string> &shaderpaths);
     ~Shader();
 
-    void Use(ShaderVariant variant = ShaderVariant::Basic);
+    // 请求的variant/pass没有编译时依次退回到该variant的Forward、Basic的Forward，并警告一次
+    void Use(ShaderVariant variant = ShaderVariant::Basic, ShaderPass pass = ShaderPass::Forward);
+    bool HasVariant(ShaderVariant variant, ShaderPass pass = ShaderPass::Forward) const
+    {
+        return programs.count(ProgramKey(variant, pass)) > 0;
+    }
     void Delete();
 
-    void SetUniform1f(const std::string &label, float v);
-    void SetUniform1i(const std::string &label, int v);
-    void SetUniformVec3f(const std::string &label, float v1, float v2, float v3);
-    void SetUniformVec3i(const std::string &label, int v1, int v2, int v3);
-    void SetUniformVec4f(const std::string &label, float v1, float v2, float v3, float v4);
-    void SetUniformVec4i(const std::string &label, int v1, int v2, int v3, int v4);
-    void SetUniformMat4x4f(const std::string &label, const glm::mat4 &mat);
+    // 当前program中uniform的location，不存在时返回-1（每个uniform只警告一次）
+    int GetUniformLocation(uint32_t id);
+    // 当前program中uniform block的下标，不存在时返回-1
+    int GetUniformBlockIndex(uint32_t id) const;
+    unsigned int CurrentProgram() const { return currentProgram; }
+    // Basic变体中uniform block的布局（各变体中同名block的声明应一致），不存在时返回nullptr
+    const UniformBlockLayout *GetBlockLayout(uint32_t blockId) const;
+
+    void SetUniform1f(uint32_t id, float v);
+    void SetUniform1i(uint32_t id, int v);
+    void SetUniformVec3f(uint32_t id, float v1, float v2, float v3);
+    void SetUniformVec3i(uint32_t id, int v1, int v2, int v3);
+    void SetUniformVec4f(uint32_t id, float v1, float v2, float v3, float v4);
+    void SetUniformVec4i(uint32_t id, int v1, int v2, int v3, int v4);
+    void SetUniformMat4x4f(uint32_t id, const glm::mat4 &mat);
 
-    void SetUniforms(const std::unordered_map<std::string, std::pair<std::string, std::any>> &uniforms);
+    void SetUniform1f(std::string_view label, float v) { SetUniform1f(PropertyToID(label), v); }
+    void SetUniform1i(std::string_view label, int v) { SetUniform1i(PropertyToID(label), v); }
+    void SetUniformVec3f(std::string_view label, float v1, float v2, float v3) { SetUniformVec3f(PropertyToID(label), v1, v2, v3); }
+    void SetUniformVec3i(std::string_view label, int v1, int v2, int v3) { SetUniformVec3i(PropertyToID(label), v1, v2, v3); }
+    void SetUniformVec4f(std::string_view label, float v1, float v2, float v3, float v4) { SetUniformVec4f(PropertyToID(label), v1, v2, v3, v4); }
+    void SetUniformVec4i(std::string_view label, int v1, int v2, int v3, int v4) { SetUniformVec4i(PropertyToID(label), v1, v2, v3, v4); }
+    void SetUniformMat4x4f(std::string_view label, const glm::mat4 &mat) { SetUniformMat4x4f(PropertyToID(label), mat); }
 };
 
 #endif // SHADER_H
@@ -0,0 +1,119 @@
+#include "Skeleton.h"
+#include "GLState.h"
+#include "PrimitiveRegistry.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+static constexpr uint32_t ID_VIEW = Shader::PropertyToID("view");
+static constexpr uint32_t ID_PROJECTION = Shader::PropertyToID("projection");
+static constexpr uint32_t ID_MODEL = Shader::PropertyToID("model");
+
+Skeleton::~Skeleton()
+{
+    if (ssbo)
+    {
+        GLState::Instance().ForgetBuffer(ssbo);
+        glDeleteBuffers(1, &ssbo);
+    }
+}
+
+void Skeleton::BuildInstances()
+{
+    size_t jointCount = heads.size();
+    instances.clear();
+    instances.reserve(jointCount * 2);
+
+    glm::mat4 sphereScale = glm::scale(glm::mat4(1.0f), glm::vec3(nodeRadius));
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), heads[i]) * sphereScale;
+        instances.push_back({model, nodeColor});
+    }
+
+    // 圆锥底面在父关节，尖端指向子关节；原始高度为2，尖端朝+y
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        int parent = i < parents.size() ? parents[i] : -1;
+        if (parent < 0 || parent >= (int)jointCount)
+            continue;
+        glm::vec3 base = heads[parent];
+        float length = glm::distance(heads[i], base);
+        if (length <= 0.0f)
+            continue;
+        glm::vec3 direction = (heads[i] - base) / length;
+        float height = length * 0.5f;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), base) *
+                          glm::mat4_cast(glm::rotation(glm::vec3(0.0f, 1.0f, 0.0f), direction)) *
+                          glm::scale(glm::mat4(1.0f), glm::vec3(length * linkRadiusRatio, height, length * linkRadiusRatio));
+        instances.push_back({model, linkColor});
+    }
+    linkCount = instances.size() - jointCount;
+    dirty = false;
+    uploadPending = true;
+}
+
+void Skeleton::UploadInstances()
+{
+    GLState &state = GLState::Instance();
+    if (instances.size() > ssboCapacity)
+    {
+        if (ssbo)
+        {
+            state.ForgetBuffer(ssbo);
+            glDeleteBuffers(1, &ssbo);
+        }
+        ssboCapacity = instances.size();
+        glCreateBuffers(1, &ssbo);
+        glNamedBufferStorage(ssbo, ssboCapacity * sizeof(Instance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    if (!instances.empty())
+        glNamedBufferSubData(ssbo, 0, instances.size() * sizeof(Instance), instances.data());
+    uploadPending = false;
+}
+
+void Skeleton::update()
+{
+    if (dirty)
+        BuildInstances();
+}
+
+void Skeleton::draw()
+{
+    if (!material || heads.empty())
+        return;
+    Renderer::Instance().SubmitRenderable(this, material->renderQueue);
+}
+
+void Skeleton::Render(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix, RenderStats &stats)
+{
+    if (!sphere)
+    {
+        sphere = PrimitiveRegistry::Instance().Get(PrimitiveType::Sphere);
+        cone = PrimitiveRegistry::Instance().Get(PrimitiveType::Cone);
+    }
+    // 本帧更新之后才加入场景或才修改时在这里生成
+    if (dirty)
+        BuildInstances();
+    if (uploadPending)
+        UploadInstances();
+
+    const std::shared_ptr<Shader> &shader = material->GetShader();
+    shader->Use();
+    shader->SetUniformMat4x4f(ID_VIEW, viewMatrix);
+    shader->SetUniformMat4x4f(ID_PROJECTION, projMatrix);
+    shader->SetUniformMat4x4f(ID_MODEL, transform.localToWorld());
+    material->ApplyRenderState();
+    material->ApplyUniforms();
+    GLState::Instance().BindBufferBase(GL_SHADER_STORAGE_BUFFER, SKELETON_BINDING, ssbo);
+
+    unsigned int jointCount = (unsigned int)heads.size();
+    sphere->drawInstances(shader, 0, jointCount);
+    stats.drawCalls++;
+    stats.trianglesSubmitted += (size_t)sphere->i_num / 3 * jointCount;
+    if (linkCount > 0)
+    {
+        cone->drawInstances(shader, jointCount, (unsigned int)linkCount);
+        stats.drawCalls++;
+        stats.trianglesSubmitted += (size_t)cone->i_num / 3 * linkCount;
+    }
+}
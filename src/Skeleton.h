@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Renderer.h"
+
+// 骨骼可视化：关节画成球、父子关节之间画成圆锥
+// 所有关节存放在平坦数组中，实例矩阵和颜色放在同一个SSBO里（先球后圆锥），每帧两次实例化绘制
+// 关节坐标在本对象的局部空间，一般作为模型的子对象，transform保持单位变换
+class Skeleton : public SceneObject, public Renderable
+{
+public:
+    REGISTER_SCENE_OBJECT(Skeleton)
+    // 实例数组在更新阶段由工作线程重建，绘制时只上传
+    REGISTER_SCENE_SYSTEM(Skeleton, 0, 0, RESOURCE_SKELETON_INSTANCES, JobAffinity::Any, 4)
+
+    // 与skeleton.shader中的SkeletonInstance一致（std430）
+    struct Instance
+    {
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+
+    std::vector<glm::vec3> heads;
+    std::vector<glm::vec3> tails;
+    std::vector<int> parents; // -1表示根关节
+
+    // 渲染状态和shader（需要读取SKELETON_BINDING的实例数据）
+    std::shared_ptr<Material> material;
+    glm::vec4 nodeColor = glm::vec4(1.0f);
+    glm::vec4 linkColor = glm::vec4(1.0f);
+    float nodeRadius = 0.01f;    // 局部空间中的球半径
+    float linkRadiusRatio = 0.05f; // 圆锥底面半径与长度之比
+
+    ~Skeleton() override;
+
+    // 修改关节数组或外观参数后调用，下次更新或绘制前重新生成实例数据
+    void MarkDirty() { dirty = true; }
+    size_t JointCount() const { return heads.size(); }
+    size_t LinkCount() const { return linkCount; }
+
+    void update() override;
+    void draw() override;
+    void Render(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix, RenderStats &stats) override;
+
+private:
+    // 只生成CPU端数组，可在工作线程执行
+    void BuildInstances();
+    void UploadInstances();
+
+    std::vector<Instance> instances;
+    size_t linkCount = 0;
+    bool dirty = true;
+    bool uploadPending = false;
+    GLuint ssbo = 0;
+    size_t ssboCapacity = 0; // 实例个数
+    std::shared_ptr<Mesh> sphere;
+    std::shared_ptr<Mesh> cone;
+};
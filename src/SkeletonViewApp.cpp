@@ -1,58 +1,73 @@
 #include "SkeletonViewerApp.h"
+#include "Parallel.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
-void SkeletonViewerApp::SaveFrameBuffer(const std::string &filename)
+// 截图时读回的深度，交给后台任务转换和编码
+struct DepthScreenshot
 {
-    // 获取窗口尺寸
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    std::string filename;
+    int width = 0;
+    int height = 0;
+    std::vector<float> depth;
+};
+
+// 每个并行块处理的行数
+static constexpr size_t SCREENSHOT_ROW_GRAIN = 64;
 
-    // 读取帧缓冲数据
-    std::vector<float> pixels(width * height);
-    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, pixels.data());
+static void EncodeDepthScreenshot(const DepthScreenshot &screenshot)
+{
+    int width = screenshot.width;
+    int height = screenshot.height;
+    const std::vector<float> &pixels = screenshot.depth;
 
     float near = 0.01f;
     float far = 0.6f;
-    std::vector<float> linearDepth(pixels.size());
-
-    for (size_t i = 0; i < pixels.size(); ++i)
-    {
-        float z_n = pixels[i] * 2.0f - 1.0f; // NDC [-1, 1]
-        linearDepth[i] = (2.0f * near * far) / (far + near - z_n * (far - near));
-    }
-
-    std::vector<unsigned char> grayPixels(width * height);
-    for (size_t i = 0; i < pixels.size(); ++i)
-    {
-        // 非线性 depth buffer 映射到 0~255
-        grayPixels[i] = static_cast<unsigned char>(linearDepth[i] * 255.0f);
-    }
 
+    // 线性化、映射到0~255，同时上下翻转（OpenGL的坐标系是左下角为原点）
     std::vector<unsigned char> flippedPixels(width * height);
-    for (int y = 0; y < height; ++y)
-    {
-        memcpy(&flippedPixels[y * width],
-               &grayPixels[(height - 1 - y) * width],
-               width);
-    }
-
-    // // 翻转图像（OpenGL的坐标系是左下角为原点）
-    // std::vector<unsigned char> flippedPixels(width * height * 3);
-    // for (int y = 0; y < height; ++y)
-    // {
-    //     memcpy(&flippedPixels[y * width * 3],
-    //            &pixels[(height - 1 - y) * width * 3],
-    //            width * 3);
-    // }
+    ParallelFor(0, height, SCREENSHOT_ROW_GRAIN, [&](size_t rowBegin, size_t rowEnd)
+                {
+                    for (size_t y = rowBegin; y < rowEnd; y++)
+                    {
+                        const float *src = &pixels[(height - 1 - y) * width];
+                        unsigned char *dst = &flippedPixels[y * width];
+                        for (int x = 0; x < width; x++)
+                        {
+                            float z_n = src[x] * 2.0f - 1.0f; // NDC [-1, 1]
+                            float linearDepth = (2.0f * near * far) / (far + near - z_n * (far - near));
+                            // 非线性 depth buffer 映射到 0~255
+                            dst[x] = static_cast<unsigned char>(linearDepth * 255.0f);
+                        }
+                    } });
 
     // 保存为JPG
-    if (stbi_write_jpg(filename.c_str(), width, height, 1, flippedPixels.data(), 90))
+    if (stbi_write_jpg(screenshot.filename.c_str(), width, height, 1, flippedPixels.data(), 90))
     {
-        std::cout << "Screenshot saved: " << filename << std::endl;
+        std::cout << "Screenshot saved: " << screenshot.filename << std::endl;
     }
     else
     {
-        std::cerr << "Failed to save screenshot: " << filename << std::endl;
+        std::cerr << "Failed to save screenshot: " << screenshot.filename << std::endl;
     }
+}
+
+void SkeletonViewerApp::SaveFrameBuffer(const std::string &filename)
+{
+    // 获取窗口尺寸
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    // 读取帧缓冲数据必须在主线程，转换和编码放到后台任务，不阻塞渲染
+    auto screenshot = std::make_shared<DepthScreenshot>();
+    screenshot->filename = filename;
+    screenshot->width = width;
+    screenshot->height = height;
+    screenshot->depth.resize(width * height);
+    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, screenshot->depth.data());
+
+    // 退出时JobSystem::Shutdown()会先执行完排队的任务，截图不会丢
+    JobSystem::Instance().Schedule([screenshot]
+                                   { EncodeDepthScreenshot(*screenshot); },
+                                   {}, JobAffinity::Background);
 }
\ No newline at end of file
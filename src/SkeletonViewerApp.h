@@ -4,7 +4,7 @@
 #include <imgui/imgui.h>
 #include <config.h>
 #include <filesystem>
-#include <regex>
+#include <unordered_set>
 
 #include "App.h"
 #include "Path.h"
@@ -13,6 +13,10 @@
 #include "Material.h"
 #include "SceneManager.h"
 #include "MeshManager.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "AllocationCounter.h"
+#include "ImportService.h"
 #include "EventDispatcher.h"
 
 using namespace std::filesystem;
@@ -28,26 +32,27 @@ protected:
     {
         std::shared_ptr<Shader> shader = std::make_shared<Shader>(std::unordered_map<ShaderVariant, std::string>{
             {ShaderVariant::Basic, Path(ROOT_DIR) + "assets/shader/transparent.shader"},
-            {ShaderVariant::Instanced, Path(ROOT_DIR) + "assets/shader/transparent_instanced.shader"}});
+            {ShaderVariant::Instanced, Path(ROOT_DIR) + "assets/shader/transparent_instanced.shader"},
+            {ShaderVariant::Indirect, Path(ROOT_DIR) + "assets/shader/transparent_indirect.shader"}});
 
         {
             std::shared_ptr<Material> modelMaterial = std::make_shared<Material>(shader);
-            modelMaterial->SetUniform("color", "vec4f", glm::vec4(2.0f / 255.0f, 163.0f / 255.0f, 218.0f / 255.0f, 0.3f));
+            modelMaterial->SetParam("color", glm::vec4(2.0f / 255.0f, 163.0f / 255.0f, 218.0f / 255.0f, 0.3f));
+            // 半透明：放进透明队列，用OIT一次绘制，模型自身重叠的三角形也能正确混合；背面可见，不剔除
+            // 保留depthWrite，OIT合成时写回最近深度，深度截图仍包含模型
+            modelMaterial->renderQueue = RenderQueue::Transparent;
+            modelMaterial->renderState.blend = true;
             materials["model"] = modelMaterial;
-
-            std::shared_ptr<Material> nodeMaterial = std::make_shared<Material>(shader);
-            nodeMaterial->renderQueue = RenderQueue::Overlay;
-            nodeMaterial->renderState.depthFunc = GL_ALWAYS;
-            nodeMaterial->renderState.depthWrite = false;
-            nodeMaterial->SetUniform("color", "vec4f", glm::vec4(218.0f / 255.0f, 169.0f / 255.0f, 2.0f / 255.0f, 1.0f));
-            materials["node"] = nodeMaterial;
-
-            std::shared_ptr<Material> linkMaterial = std::make_shared<Material>(shader);
-            linkMaterial->renderQueue = RenderQueue::Overlay;
-            linkMaterial->renderState.depthFunc = GL_ALWAYS;
-            linkMaterial->renderState.depthWrite = false;
-            linkMaterial->SetUniform("color", "vec4f", glm::vec4(113.0f / 255.0f, 121.0f / 255.0f, 224.0f / 255.0f, 1.0f));
-            materials["link"] = linkMaterial;
+            Renderer::Instance().SetTransparencyMode(RenderQueue::Transparent, TransparencyMode::WeightedBlended);
+
+            // 关节和连线由Skeleton实例化绘制，颜色放在实例数据里；叠加在最上层显示
+            std::shared_ptr<Shader> skeletonShader = std::make_shared<Shader>(std::unordered_map<ShaderVariant, std::string>{
+                {ShaderVariant::Basic, Path(ROOT_DIR) + "assets/shader/skeleton.shader"}});
+            std::shared_ptr<Material> skeletonMaterial = std::make_shared<Material>(skeletonShader);
+            skeletonMaterial->renderQueue = RenderQueue::Overlay;
+            skeletonMaterial->renderState.depthFunc = GL_ALWAYS;
+            skeletonMaterial->renderState.depthWrite = false;
+            materials["skeleton"] = skeletonMaterial;
         }
 
         Event::EventDispatcher::Instance().RegisterHandler<Event::DropEvent>(this, &SkeletonViewerApp::OnDropFiles);
@@ -62,9 +67,6 @@ protected:
         {
             jKeyPressed = false;
         }
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
     void RenderAfter() override
@@ -91,6 +93,42 @@ protected:
         // 右侧面板
         ImGui::Begin("Scene Objects");
         ImGui::Text("Drag .obj/.glb files here");
+        if (ImportService::Instance().PendingCount() > 0)
+        {
+            ImGui::Text("Loading %d file(s)...", ImportService::Instance().PendingCount());
+        }
+
+        const RenderStats &stats = Renderer::Instance().GetStats();
+        ImGui::Text("Draw calls: %zu  Culled: %zu  Triangles: %zu", stats.drawCalls, stats.culledDraws, stats.trianglesSubmitted);
+        ImGui::Text("Program switches: %zu  Material switches: %zu", stats.programSwitches, stats.materialSwitches);
+        bool indirect = Renderer::Instance().IndirectEnabled();
+        if (ImGui::Checkbox("Multi-draw indirect", &indirect))
+        {
+            Renderer::Instance().SetIndirectEnabled(indirect);
+        }
+        if (indirect)
+        {
+            ImGui::SameLine();
+            ImGui::Text("(%zu commands)", stats.indirectCommands);
+        }
+        bool oit = Renderer::Instance().GetTransparencyMode(RenderQueue::Transparent) == TransparencyMode::WeightedBlended;
+        if (ImGui::Checkbox("Weighted blended OIT", &oit))
+        {
+            Renderer::Instance().SetTransparencyMode(RenderQueue::Transparent,
+                                                     oit ? TransparencyMode::WeightedBlended : TransparencyMode::Sorted);
+        }
+        if (AllocationCounter::ENABLED)
+            ImGui::Text("Frame allocations: %zu", stats.frameAllocations);
+        else
+            ImGui::Text("Frame allocations: off (ENABLE_ALLOCATION_TRACKING)");
+        const GLState::Counters &glCounters = GLState::Instance().GetCounters();
+        ImGui::Text("GL state calls: %zu issued, %zu filtered", glCounters.issued, glCounters.filtered);
+        if (stats.meshlets.total > 0)
+        {
+            size_t visible = stats.meshlets.total - stats.meshlets.frustumCulled - stats.meshlets.backfaceCulled;
+            ImGui::Text("Meshlets: %zu / %zu visible", visible, stats.meshlets.total);
+            ImGui::Text("  frustum culled: %zu  backface culled: %zu", stats.meshlets.frustumCulled, stats.meshlets.backfaceCulled);
+        }
         ImGui::Separator();
 
         for (int i = 0; i < (int)droppedFiles.size(); i++)
@@ -138,128 +176,77 @@ protected:
             return;
         }
 
-        if (SceneManager::GetObject<Model>(filepathObj.filename()))
+        if (SceneManager::GetObject<Model>(filepathObj.filename()) || pendingFiles.count(filepathObj.filename()))
         {
             std::cout << "Model " << filepathObj.filename() << " already exists in the scene." << std::endl;
             return;
         }
 
-        droppedFiles.push_back(filepathObj.filename());
-
-        if (currentModel == "")
-        {
-            currentModel = filepathObj.filename();
-        }
-        else
-        {
-            auto model = SceneManager::GetObject<Model>(currentModel);
-            if (model)
-            {
-                model->SetActive(false);
-            }
-            currentModel = filepathObj.filename();
-        }
-
         auto model = std::dynamic_pointer_cast<Model>(SceneObject::create("Model", filepathObj.filename().c_str()));
-        SceneManager::AddObject(model);
+        model->directory = filepathObj.directory();
+        model->filename = filepathObj.filename();
+        model->normalizeMesh = true;
+        // 扫描模型只用于半透明显示和深度截图，16字节的量化顶点足够
+        model->vertexFormat = VertexFormat::Packed16;
+        model->optimizeMesh = true;
+        model->buildMeshlets = true;
+        model->generateLods = true;
 
         // 添加对rignet输入结果的支持，主模型obj，骨骼记录着xxx_rig.txt里面
         if (filepathObj.extension() == "obj")
         {
-            auto rig_txt = filepath.substr(0, filepath.size() - 4) + ".txt";
-            std::ifstream file(rig_txt);
+            model->rigFile = filepath.substr(0, filepath.size() - 4) + ".txt";
+        }
 
-            std::unordered_map<std::string, Vector3> jointPositions;
-            std::unordered_map<std::string, std::string> parentOf;
-            std::unordered_map<std::string, std::vector<std::string>> childrenOf;
+        // 解析在工作线程完成，完成后在Update()里加入场景
+        pendingFiles.insert(filepathObj.filename());
+        ImportService::Instance().Submit(model);
+    }
 
-            std::regex jointRegex(R"(j\s+<(.+)>\s+(.+)\s+(.+)\s+(.+))");
-            std::regex edgeRegex(R"(e\s+<(.+)>\s+<(.+)>)");
+    void Update() override
+    {
+        App::Update();
 
-            if (file.is_open())
-            {
-                std::string line;
-                while (std::getline(file, line))
-                {
-                    if (line[0] == 'j')
-                    {
-                        std::smatch match;
-                        if (std::regex_match(line, match, jointRegex))
-                        {
-                            std::string name = match[1];
-                            float x = std::stof(match[2]);
-                            float y = std::stof(match[3]);
-                            float z = std::stof(match[4]);
-                            jointPositions[name] = {x, y, z};
-                        }
-                    }
-                    else if (line[0] == 'e')
-                    {
-                        std::smatch match;
-                        if (std::regex_match(line, match, edgeRegex))
-                        {
-                            std::string parent = match[1];
-                            std::string child = match[2];
-                            parentOf[child] = parent;
-                            childrenOf[parent].push_back(child);
-                        }
-                    }
-                    // std::istringstream iss(line);
-                    // std::string type;
-                    // iss >> type;
-
-                    // if (type == "joints")
-                    // {
-                    //     std::string name;
-                    //     float x, y, z;
-                    //     iss >> name >> x >> y >> z;
-                    //     jointPositions[name] = {x, y, z};
-                    // }
-                    // else if (type == "hier")
-                    // {
-                    //     std::string parent, child;
-                    //     iss >> parent >> child;
-                    //     parentOf[child] = parent;
-                    //     childrenOf[parent].push_back(child);
-                    // }
-                }
-                file.close();
-            }
+        completedImports.clear();
+        ImportService::Instance().PollCompleted(completedImports);
+        for (auto &result : completedImports)
+        {
+            FinishImport(result);
+        }
+    }
 
-            for (const auto &[name, head] : jointPositions)
-            {
-                Vector3 tail = head; // 默认tail = head
-                if (childrenOf.find(name) != childrenOf.end())
-                {
-                    const auto &children = childrenOf[name];
-                    // 若有多个子节点，取平均位置
-                    Vector3 avg = {0, 0, 0};
-                    for (const auto &c : children)
-                    {
-                        Vector3 p = jointPositions[c];
-                        avg.x += p.x;
-                        avg.y += p.y;
-                        avg.z += p.z;
-                    }
-                    float inv = 1.0f / children.size();
-                    tail = {avg.x * inv, avg.y * inv, avg.z * inv};
-                }
+    // 主线程：上传GPU并把导入完成的模型加入场景
+    void FinishImport(const ImportResult &result)
+    {
+        auto &model = result.model;
+        pendingFiles.erase(model->filename);
+        if (!result.success)
+        {
+            std::cout << "Failed to load model: " << model->filename << std::endl;
+            return;
+        }
 
-                std::string parent = parentOf.count(name) ? parentOf[name] : "none";
-                model->bones[name] = std::make_tuple(head, tail, parent);
+        droppedFiles.push_back(model->filename);
+
+        if (currentModel != "")
+        {
+            auto prevModel = SceneManager::GetObject<Model>(currentModel);
+            if (prevModel)
+            {
+                prevModel->SetActive(false);
             }
         }
+        currentModel = model->filename;
 
-        model->directory = filepathObj.directory();
-        model->filename = filepathObj.filename();
-        model->normalizeMesh = true;
         model->SetMaterial(materials["model"]);
-        model->awake();
+        model->upload();
+        SceneManager::AddObject(model);
         // model->printBoneInfo();
 
-        model->AddBoneNodes(materials["node"], materials["link"]);
+        model->AddSkeleton(materials["skeleton"], glm::vec4(218.0f / 255.0f, 169.0f / 255.0f, 2.0f / 255.0f, 1.0f),
+                           glm::vec4(113.0f / 255.0f, 121.0f / 255.0f, 224.0f / 255.0f, 1.0f));
 
-        std::cout << "Added model: " << filepathObj.filename() << std::endl;
+        std::cout << "Added model: " << model->filename << " (" << result.seconds << "s on worker)" << std::endl;
     }
 
     void OnKeyPressed(const std::shared_ptr<Event::KeyPressedEvent> &event)
@@ -276,7 +263,7 @@ protected:
                 auto model = SceneManager::GetObject<Model>(currentModel);
                 if (model)
                 {
-                    SceneManager::Remove(currentModel);
+                    SceneManager::Remove(model->handle);
                 }
 
                 droppedFiles.erase(std::remove(droppedFiles.begin(), droppedFiles.end(), currentModel), droppedFiles.end());
@@ -305,5 +292,7 @@ private:
     int selectedIndex = -1;
     std::string currentModel = "";
     std::vector<std::string> droppedFiles;
+    std::unordered_set<std::string> pendingFiles; // 已提交、还在导入中的文件
+    std::vector<ImportResult> completedImports;
     std::unordered_map<std::string, std::shared_ptr<Material>> materials;
 };
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 带代数的句柄：index指向槽位，generation在槽位被释放时加一，旧句柄随之失效
+struct SlotHandle
+{
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != INVALID_INDEX; }
+    uint64_t Packed() const { return (uint64_t(generation) << 32) | index; }
+    bool operator==(const SlotHandle &other) const = default;
+};
+
+// 值紧密存放在values中（可直接遍历），槽位表把句柄映射到紧密下标
+// 插入、查找、删除都是O(1)；删除时把最后一个值换到被删的位置，遍历顺序会改变
+template <typename T>
+class SlotMap
+{
+public:
+    SlotHandle Insert(T value)
+    {
+        uint32_t slotIndex;
+        if (freeHead != SlotHandle::INVALID_INDEX)
+        {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        }
+        else
+        {
+            slotIndex = (uint32_t)slots.size();
+            slots.push_back({0, 0});
+        }
+        slots[slotIndex].denseIndex = (uint32_t)values.size();
+        values.push_back(std::move(value));
+        denseToSlot.push_back(slotIndex);
+        return {slotIndex, slots[slotIndex].generation};
+    }
+
+    // 句柄已失效时返回false
+    bool Remove(SlotHandle handle)
+    {
+        if (!Contains(handle))
+            return false;
+        Slot &slot = slots[handle.index];
+        uint32_t denseIndex = slot.denseIndex;
+        uint32_t last = (uint32_t)values.size() - 1;
+        if (denseIndex != last)
+        {
+            values[denseIndex] = std::move(values[last]);
+            denseToSlot[denseIndex] = denseToSlot[last];
+            slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        slot.generation++;
+        slot.denseIndex = freeHead;
+        freeHead = handle.index;
+        return true;
+    }
+
+    bool Contains(SlotHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation &&
+               !IsFree(handle.index);
+    }
+
+    // 句柄失效时返回nullptr；指针在下一次Insert/Remove之前有效
+    T *Get(SlotHandle handle) { return Contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr; }
+    const T *Get(SlotHandle handle) const { return Contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr; }
+
+    // 按紧密下标遍历
+    size_t Size() const { return values.size(); }
+    T &At(size_t denseIndex) { return values[denseIndex]; }
+    const T &At(size_t denseIndex) const { return values[denseIndex]; }
+    SlotHandle HandleAt(size_t denseIndex) const
+    {
+        uint32_t slotIndex = denseToSlot[denseIndex];
+        return {slotIndex, slots[slotIndex].generation};
+    }
+    const std::vector<T> &Values() const { return values; }
+
+    void Clear()
+    {
+        for (size_t i = values.size(); i-- > 0;)
+            Remove(HandleAt(i));
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t denseIndex; // 空闲时为下一个空闲槽位
+        uint32_t generation;
+    };
+
+    // 空闲槽位的denseIndex指向其他槽位或INVALID_INDEX，占用的槽位反向映射回自己
+    bool IsFree(uint32_t slotIndex) const
+    {
+        uint32_t denseIndex = slots[slotIndex].denseIndex;
+        return denseIndex >= denseToSlot.size() || denseToSlot[denseIndex] != slotIndex;
+    }
+
+    std::vector<Slot> slots;
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+    uint32_t freeHead = SlotHandle::INVALID_INDEX;
+};
@@ -6,31 +6,14 @@
 #include <stb_image.h>
 #include <iostream>
 #include <GL/glew.h>
-Texture::Texture(const std::string &dict, const std::string &file, TextureType type) : texid(0), type(type)
+#include "GLState.h"
+Texture::Texture(const std::string &dict, const std::string &file, TextureType type) : texid(0), type(type), dict(dict), file(file)
 {
     std::string filepath = dict + "/" + file;
-    int w, h, channels;
-    unsigned char *img = stbi_load(filepath.c_str(), &w, &h, &channels, 0);
+    unsigned char *img = stbi_load(filepath.c_str(), &width, &height, &channels, 0);
     if (img)
     {
-        GLenum format = GL_RED;
-        if (channels == 1)
-            format = GL_RED;
-        else if (channels == 3)
-            format = GL_RGB;
-        else if (channels == 4)
-            format = GL_RGBA;
-
-        glGenTextures(1, &texid);
-        glBindTexture(GL_TEXTURE_2D, texid);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, img);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+        pixels.assign(img, img + (size_t)width * height * channels);
         stbi_image_free(img);
     }
     else
@@ -39,13 +22,35 @@ Texture::Texture(const std::string &dict, const std::string &file, TextureType t
     }
 }
 
-void Texture::bind(unsigned int channel)
+void Texture::upload()
 {
-    /*glBindTexture(GL_TEXTURE_2D, 0);*/
-    glActiveTexture(GL_TEXTURE0 + channel);
-    glBindTexture(GL_TEXTURE_2D, texid);
+    if (texid != 0 || pixels.empty())
+        return;
+
+    GLenum format = GL_RED;
+    if (channels == 1)
+        format = GL_RED;
+    else if (channels == 3)
+        format = GL_RGB;
+    else if (channels == 4)
+        format = GL_RGBA;
+
+    glGenTextures(1, &texid);
+    GLState::Instance().BindTexture(0, texid);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // 已经在显存里了，释放CPU侧的像素
+    pixels.clear();
+    pixels.shrink_to_fit();
 }
-void Texture::unbind()
+
+void Texture::bind(unsigned int channel)
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+    GLState::Instance().BindTexture(channel, texid);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 enum TextureType
 {
@@ -13,9 +14,20 @@ class Texture
 public:
     unsigned int texid;
     TextureType type;
+    std::string dict;
+    std::string file;
 
     Texture() = default;
+    // 只在CPU侧解码图片，可在工作线程调用
     Texture(const std::string &dict, const std::string &file, TextureType type);
+
+    // 上传到GPU，需要在主线程（GL上下文）调用
+    void upload();
     void bind(unsigned int channel);
-    void unbind();
-};
\ No newline at end of file
+
+private:
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels;
+};
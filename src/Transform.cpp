@@ -3,66 +3,98 @@
 
 Vector3 Transform::position() const
 {
-    return _position;
+    return TransformStore::Instance().GetPosition(id);
 }
 
 void Transform::position(Vector3 pos)
 {
-    _position = pos;
-    calcuLToW();
+    TransformStore::Instance().SetPosition(id, pos);
 }
 
 Vector3 Transform::eulerAngles() const
 {
-    return _eulerAngles;
+    return TransformStore::Instance().GetEulerAngles(id);
 }
 
 void Transform::eulerAngles(Vector3 eulerangle)
 {
-    _eulerAngles = eulerangle;
-    _rotation = glm::qua<float>(glm::radians(_eulerAngles));
-    calcuLToW();
+    TransformStore::Instance().SetRotation(id, glm::qua<float>(glm::radians(eulerangle)), eulerangle);
 }
 
 Vector3 Transform::scale() const
 {
-    return _scale;
+    return TransformStore::Instance().GetScale(id);
 }
 
 void Transform::scale(Vector3 scale)
 {
-    _scale = scale;
-    calcuLToW();
+    TransformStore::Instance().SetScale(id, scale);
+}
+
+void Transform::parent(const Transform *parent)
+{
+    TransformStore::Instance().SetParent(id, parent ? parent->id : TransformStore::INVALID_ID);
+}
+
+bool Transform::hasParent() const
+{
+    return TransformStore::Instance().GetParent(id) != TransformStore::INVALID_ID;
+}
+
+glm::mat4 Transform::localMatrix() const
+{
+    return TransformStore::Instance().GetLocalMatrix(id);
 }
 
 glm::mat4 Transform::localToWorld() const
 {
-    return _localToWorld;
+    return TransformStore::Instance().GetLocalToWorld(id);
 }
 
 Transform::Transform()
-    : _position(0), _eulerAngles(0), _scale(1)
+    : id(TransformStore::Instance().Allocate())
 {
-    _rotation = glm::qua<float>(glm::radians(_eulerAngles));
-    calcuLToW();
+}
+
+Transform::~Transform()
+{
+    TransformStore::Instance().Free(id);
+}
+
+Transform::Transform(const Transform &other)
+    : Transform()
+{
+    *this = other;
+}
+
+Transform &Transform::operator=(const Transform &other)
+{
+    if (this != &other)
+    {
+        TransformStore &store = TransformStore::Instance();
+        store.SetPosition(id, store.GetPosition(other.id));
+        store.SetRotation(id, store.GetRotation(other.id), store.GetEulerAngles(other.id));
+        store.SetScale(id, store.GetScale(other.id));
+        // 没有父节点的transform可在任意线程复制；只有父节点不同时才改层级，这一步要求在主线程
+        uint32_t parent = store.GetParent(other.id);
+        if (parent != store.GetParent(id))
+            store.SetParent(id, parent);
+    }
+    return *this;
 }
 
 Quaternion Transform::rotation() const
 {
-    return _rotation;
+    return TransformStore::Instance().GetRotation(id);
 }
 
 void Transform::eulerAngles(float yaw, float pitch, float roll)
 {
-    Vector3 eulerangle(pitch, yaw, roll);
-    _eulerAngles = eulerangle;
-    _rotation = glm::qua<float>(glm::radians(_eulerAngles));
-    calcuLToW();
+    eulerAngles(Vector3(pitch, yaw, roll));
 }
 
 void Transform::rotate(Vector3 originDir, Vector3 targetDir)
 {
-    _rotation = glm::rotation(originDir, targetDir);
-    _eulerAngles = glm::degrees(glm::eulerAngles(_rotation));
-    calcuLToW();
-}
+    Quaternion rotation = glm::rotation(originDir, targetDir);
+    TransformStore::Instance().SetRotation(id, rotation, glm::degrees(glm::eulerAngles(rotation)));
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/gtc/quaternion.hpp>
+#include "TransformStore.h"
 
 typedef glm::vec2 Vector2;
 typedef glm::vec3 Vector3;
@@ -9,15 +10,11 @@ typedef glm::mat4 Mat4;
 typedef glm::mat3x4 Mat3x4;
 typedef glm::qua<float> Quaternion;
 
+// 数据存放在TransformStore中，这里只保存下标；setter只标记脏，localToWorld在TransformStore::UpdateDirty()中批量重算
+// position/rotation/scale都是相对父节点的
 class Transform
 {
-    Vector3 _position;
-    Vector3 _eulerAngles;
-    Vector3 _scale;
-    Quaternion _rotation;
-    glm::mat4 _localToWorld;
-
-    void calcuLToW();
+    uint32_t id;
 
 public:
     Vector3 position() const;
@@ -37,16 +34,19 @@ public:
 
     Vector3 scale() const;
     void scale(Vector3 scale);
+    // 设定父节点，nullptr表示根节点；局部分量不变。父节点的Transform析构时子节点变成根节点
+    void parent(const Transform *parent);
+    bool hasParent() const;
+
+    // trans * rotate * scale
+    glm::mat4 localMatrix() const;
+    // 父节点的localToWorld * localMatrix
     glm::mat4 localToWorld() const;
 
     Transform();
+    ~Transform();
+    // 复制时分配新的一项并复制局部分量和父节点
+    // 源或目标有父节点时会修改层级，只能在主线程复制；都没有父节点时可在任意线程复制
+    Transform(const Transform &other);
+    Transform &operator=(const Transform &other);
 };
-
-// trans * rotate * scale
-inline void Transform::calcuLToW()
-{
-    _localToWorld = glm::mat4(1);
-    _localToWorld = glm::translate(_localToWorld, _position);
-    _localToWorld = _localToWorld * glm::mat4_cast(_rotation);
-    _localToWorld = glm::scale(_localToWorld, _scale);
-}
\ No newline at end of file
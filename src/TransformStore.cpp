@@ -0,0 +1,442 @@
+#include "TransformStore.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define TRANSFORM_SSE 1
+#endif
+
+// 重算局部矩阵时每个任务处理的页数，以及向下传播时每个任务大约处理的节点数
+static constexpr size_t COMPOSE_PAGE_GRAIN = 8;
+static constexpr size_t PROPAGATE_GRAIN = 8192;
+
+uint32_t TransformStore::Allocate()
+{
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            uint32_t count = pageCount.load(std::memory_order_relaxed);
+            if (count == MAX_PAGES)
+            {
+                std::cout << "[TransformStore] out of pages (" << MAX_PAGES * PAGE_SIZE << " transforms)" << std::endl;
+                std::abort();
+            }
+            pages[count] = std::make_unique<Page>();
+            for (auto &word : pages[count]->dirty)
+                word.store(0, std::memory_order_relaxed);
+            // 新页的空闲项倒序压入，先分配的下标小
+            for (uint32_t slot = PAGE_SIZE; slot-- > 1;)
+                freeIds.push_back(count * PAGE_SIZE + slot);
+            id = count * PAGE_SIZE;
+            pageCount.store(count + 1, std::memory_order_release);
+        }
+
+        // 新项是没有子节点的根，直接追加到拓扑序末尾
+        Page &page = PageOf(id);
+        uint32_t slot = id % PAGE_SIZE;
+        page.parent[slot] = page.firstChild[slot] = page.prevSibling[slot] = page.nextSibling[slot] = INVALID_ID;
+        page.alive[slot] = true;
+        if (!orderDirty)
+        {
+            page.orderIndex[slot] = (uint32_t)order.size();
+            order.push_back(id);
+            subtreeSize.push_back(1);
+        }
+    }
+    liveCount.fetch_add(1, std::memory_order_relaxed);
+
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    page.positionX[slot] = page.positionY[slot] = page.positionZ[slot] = 0.0f;
+    page.rotationX[slot] = page.rotationY[slot] = page.rotationZ[slot] = 0.0f;
+    page.rotationW[slot] = 1.0f;
+    page.scaleX[slot] = page.scaleY[slot] = page.scaleZ[slot] = 1.0f;
+    page.eulerAngles[slot] = glm::vec3(0.0f);
+    page.localMatrix[slot] = glm::mat4(1.0f);
+    page.localToWorld[slot] = glm::mat4(1.0f);
+    return id;
+}
+
+void TransformStore::Free(uint32_t id)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    page.dirty[slot / 64].fetch_and(~(uint64_t(1) << (slot % 64)), std::memory_order_relaxed);
+    liveCount.fetch_sub(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // 子节点变成根节点，局部分量不变
+    for (uint32_t child = page.firstChild[slot]; child != INVALID_ID;)
+    {
+        Page &childPage = PageOf(child);
+        uint32_t childSlot = child % PAGE_SIZE;
+        uint32_t next = childPage.nextSibling[childSlot];
+        childPage.parent[childSlot] = childPage.prevSibling[childSlot] = childPage.nextSibling[childSlot] = INVALID_ID;
+        MarkDirty(childPage, childSlot);
+        child = next;
+    }
+    page.firstChild[slot] = INVALID_ID;
+    Unlink(id);
+    page.alive[slot] = false;
+    orderDirty = true;
+    freeIds.push_back(id);
+}
+
+void TransformStore::Unlink(uint32_t id)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    uint32_t parent = page.parent[slot];
+    if (parent == INVALID_ID)
+        return;
+    uint32_t prev = page.prevSibling[slot];
+    uint32_t next = page.nextSibling[slot];
+    if (prev != INVALID_ID)
+        PageOf(prev).nextSibling[prev % PAGE_SIZE] = next;
+    else
+        PageOf(parent).firstChild[parent % PAGE_SIZE] = next;
+    if (next != INVALID_ID)
+        PageOf(next).prevSibling[next % PAGE_SIZE] = prev;
+    page.parent[slot] = page.prevSibling[slot] = page.nextSibling[slot] = INVALID_ID;
+}
+
+void TransformStore::SetParent(uint32_t id, uint32_t parent)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    if (page.parent[slot] == parent)
+        return;
+    for (uint32_t ancestor = parent; ancestor != INVALID_ID; ancestor = GetParent(ancestor))
+    {
+        if (ancestor == id)
+        {
+            std::cout << "[TransformStore] SetParent would create a cycle, ignored" << std::endl;
+            return;
+        }
+    }
+
+    Unlink(id);
+    if (parent != INVALID_ID)
+    {
+        Page &parentPage = PageOf(parent);
+        uint32_t parentSlot = parent % PAGE_SIZE;
+        uint32_t first = parentPage.firstChild[parentSlot];
+        page.parent[slot] = parent;
+        page.nextSibling[slot] = first;
+        if (first != INVALID_ID)
+            PageOf(first).prevSibling[first % PAGE_SIZE] = id;
+        parentPage.firstChild[parentSlot] = id;
+    }
+    MarkDirty(page, slot);
+    orderDirty = true;
+}
+
+void TransformStore::RebuildOrder()
+{
+    order.clear();
+    subtreeSize.clear();
+    uint32_t count = pageCount.load(std::memory_order_acquire);
+    for (uint32_t p = 0; p < count; p++)
+    {
+        Page &rootPage = *pages[p];
+        for (uint32_t rootSlot = 0; rootSlot < PAGE_SIZE; rootSlot++)
+        {
+            if (!rootPage.alive[rootSlot] || rootPage.parent[rootSlot] != INVALID_ID)
+                continue;
+
+            // 非递归的先序遍历，回溯时写入子树大小
+            uint32_t root = p * PAGE_SIZE + rootSlot;
+            uint32_t node = root;
+            while (true)
+            {
+                Page &page = PageOf(node);
+                uint32_t slot = node % PAGE_SIZE;
+                page.orderIndex[slot] = (uint32_t)order.size();
+                order.push_back(node);
+                subtreeSize.push_back(1);
+                if (page.firstChild[slot] != INVALID_ID)
+                {
+                    node = page.firstChild[slot];
+                    continue;
+                }
+                while (true)
+                {
+                    Page &donePage = PageOf(node);
+                    uint32_t doneSlot = node % PAGE_SIZE;
+                    uint32_t index = donePage.orderIndex[doneSlot];
+                    subtreeSize[index] = (uint32_t)order.size() - index;
+                    if (node == root)
+                        break;
+                    if (donePage.nextSibling[doneSlot] != INVALID_ID)
+                    {
+                        node = donePage.nextSibling[doneSlot];
+                        break;
+                    }
+                    node = donePage.parent[doneSlot];
+                }
+                if (node == root)
+                    break;
+            }
+        }
+    }
+    orderDirty = false;
+}
+
+glm::vec3 TransformStore::GetPosition(uint32_t id) const
+{
+    const Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    return glm::vec3(page.positionX[slot], page.positionY[slot], page.positionZ[slot]);
+}
+
+void TransformStore::SetPosition(uint32_t id, const glm::vec3 &position)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    page.positionX[slot] = position.x;
+    page.positionY[slot] = position.y;
+    page.positionZ[slot] = position.z;
+    MarkDirty(page, slot);
+}
+
+glm::quat TransformStore::GetRotation(uint32_t id) const
+{
+    const Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    return glm::quat(page.rotationW[slot], page.rotationX[slot], page.rotationY[slot], page.rotationZ[slot]);
+}
+
+glm::vec3 TransformStore::GetEulerAngles(uint32_t id) const
+{
+    return PageOf(id).eulerAngles[id % PAGE_SIZE];
+}
+
+void TransformStore::SetRotation(uint32_t id, const glm::quat &rotation, const glm::vec3 &eulerAngles)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    page.rotationX[slot] = rotation.x;
+    page.rotationY[slot] = rotation.y;
+    page.rotationZ[slot] = rotation.z;
+    page.rotationW[slot] = rotation.w;
+    page.eulerAngles[slot] = eulerAngles;
+    MarkDirty(page, slot);
+}
+
+glm::vec3 TransformStore::GetScale(uint32_t id) const
+{
+    const Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    return glm::vec3(page.scaleX[slot], page.scaleY[slot], page.scaleZ[slot]);
+}
+
+void TransformStore::SetScale(uint32_t id, const glm::vec3 &scale)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    page.scaleX[slot] = scale.x;
+    page.scaleY[slot] = scale.y;
+    page.scaleZ[slot] = scale.z;
+    MarkDirty(page, slot);
+}
+
+glm::mat4 TransformStore::GetLocalMatrix(uint32_t id)
+{
+    Page &page = PageOf(id);
+    uint32_t slot = id % PAGE_SIZE;
+    // 只重算局部矩阵，不清脏位，UpdateDirty仍会更新整棵子树
+    if (IsDirty(id))
+        Compose(page, slot);
+    return page.localMatrix[slot];
+}
+
+glm::mat4 TransformStore::GetLocalToWorld(uint32_t id)
+{
+    bool stale = false;
+    for (uint32_t node = id; node != INVALID_ID && !stale; node = GetParent(node))
+        stale = IsDirty(node);
+    if (!stale)
+        return PageOf(id).localToWorld[id % PAGE_SIZE];
+
+    glm::mat4 localToWorld = GetLocalMatrix(id);
+    for (uint32_t node = GetParent(id); node != INVALID_ID; node = GetParent(node))
+        localToWorld = GetLocalMatrix(node) * localToWorld;
+    return localToWorld;
+}
+
+// out = parent * local，均为仿射矩阵
+static void MultiplyMatrix(const glm::mat4 &parent, const glm::mat4 &local, glm::mat4 &out)
+{
+#ifdef TRANSFORM_SSE
+    __m128 c0 = _mm_loadu_ps(&parent[0][0]);
+    __m128 c1 = _mm_loadu_ps(&parent[1][0]);
+    __m128 c2 = _mm_loadu_ps(&parent[2][0]);
+    __m128 c3 = _mm_loadu_ps(&parent[3][0]);
+    for (int c = 0; c < 4; c++)
+    {
+        __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(local[c][0])), _mm_mul_ps(c1, _mm_set1_ps(local[c][1]))),
+                                   _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(local[c][2])), _mm_mul_ps(c3, _mm_set1_ps(local[c][3]))));
+        _mm_storeu_ps(&out[c][0], column);
+    }
+#else
+    out = parent * local;
+#endif
+}
+
+// 与glm::mat4_cast一致的旋转矩阵，每列乘以对应的缩放，第4列为平移
+void TransformStore::Compose(Page &page, uint32_t slot)
+{
+    float x = page.rotationX[slot], y = page.rotationY[slot], z = page.rotationZ[slot], w = page.rotationW[slot];
+    float sx = page.scaleX[slot], sy = page.scaleY[slot], sz = page.scaleZ[slot];
+    glm::mat4 &m = page.localMatrix[slot];
+    m[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + w * z) * sx, 2.0f * (x * z - w * y) * sx, 0.0f);
+    m[1] = glm::vec4(2.0f * (x * y - w * z) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z + w * x) * sy, 0.0f);
+    m[2] = glm::vec4(2.0f * (x * z + w * y) * sz, 2.0f * (y * z - w * x) * sz, (1.0f - 2.0f * (x * x + y * y)) * sz, 0.0f);
+    m[3] = glm::vec4(page.positionX[slot], page.positionY[slot], page.positionZ[slot], 1.0f);
+}
+
+void TransformStore::Compose4(Page &page, const uint32_t *slots)
+{
+#ifdef TRANSFORM_SSE
+    // 4项连续且对齐时直接加载，否则逐项收集到同一寄存器的4个通道
+    bool contiguous = slots[0] % 4 == 0 && slots[3] == slots[0] + 3;
+    auto load = [&](const float *values)
+    {
+        if (contiguous)
+            return _mm_load_ps(values + slots[0]);
+        return _mm_setr_ps(values[slots[0]], values[slots[1]], values[slots[2]], values[slots[3]]);
+    };
+
+    __m128 x = load(page.rotationX), y = load(page.rotationY), z = load(page.rotationZ), w = load(page.rotationW);
+    __m128 sx = load(page.scaleX), sy = load(page.scaleY), sz = load(page.scaleZ);
+    __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    // columns[c][r]：4项第c列第r行
+    __m128 columns[4][4];
+    columns[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+    columns[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+    columns[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+    columns[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+    columns[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+    columns[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+    columns[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+    columns[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+    columns[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+    columns[3][0] = load(page.positionX);
+    columns[3][1] = load(page.positionY);
+    columns[3][2] = load(page.positionZ);
+    for (int c = 0; c < 3; c++)
+        columns[c][3] = _mm_setzero_ps();
+    columns[3][3] = one;
+
+    // 转置后每个寄存器是某一项的一列
+    for (int c = 0; c < 4; c++)
+    {
+        __m128 r0 = columns[c][0], r1 = columns[c][1], r2 = columns[c][2], r3 = columns[c][3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&page.localMatrix[slots[0]][c][0], r0);
+        _mm_storeu_ps(&page.localMatrix[slots[1]][c][0], r1);
+        _mm_storeu_ps(&page.localMatrix[slots[2]][c][0], r2);
+        _mm_storeu_ps(&page.localMatrix[slots[3]][c][0], r3);
+    }
+#else
+    for (int k = 0; k < 4; k++)
+        Compose(page, slots[k]);
+#endif
+}
+
+size_t TransformStore::UpdateDirty()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (orderDirty)
+        RebuildOrder();
+
+    // 1. 各页互不相关，分页并行重算局部矩阵，脏项在拓扑序中的位置记在页内
+    uint32_t count = pageCount.load(std::memory_order_acquire);
+    ParallelFor(0, count, COMPOSE_PAGE_GRAIN, [this](size_t pageBegin, size_t pageEnd)
+                {
+                    uint32_t slots[PAGE_SIZE];
+                    for (size_t p = pageBegin; p < pageEnd; p++)
+                    {
+                        Page &page = *pages[p];
+                        // 先清脏位再读分量，期间其他线程的修改会重新置位，下次再算
+                        uint32_t dirtyCount = 0;
+                        for (uint32_t word = 0; word < PAGE_SIZE / 64; word++)
+                        {
+                            if (page.dirty[word].load(std::memory_order_relaxed) == 0)
+                                continue;
+                            uint64_t mask = page.dirty[word].exchange(0, std::memory_order_acquire);
+                            while (mask)
+                            {
+                                slots[dirtyCount++] = word * 64 + (uint32_t)std::countr_zero(mask);
+                                mask &= mask - 1;
+                            }
+                        }
+
+                        uint32_t i = 0;
+                        for (; i + 4 <= dirtyCount; i += 4)
+                            Compose4(page, slots + i);
+                        for (; i < dirtyCount; i++)
+                            Compose(page, slots[i]);
+                        for (i = 0; i < dirtyCount; i++)
+                            page.dirtyOrder[i] = page.orderIndex[slots[i]];
+                        page.dirtyCount = dirtyCount;
+                    } });
+
+    dirtyPositions.clear();
+    for (uint32_t p = 0; p < count; p++)
+    {
+        Page &page = *pages[p];
+        dirtyPositions.insert(dirtyPositions.end(), page.dirtyOrder, page.dirtyOrder + page.dirtyCount);
+    }
+
+    // 2. 按拓扑序找出脏子树，已被祖先覆盖的跳过；不同子树互不重叠，可以并行从上往下重算
+    std::sort(dirtyPositions.begin(), dirtyPositions.end());
+    dirtyRanges.clear();
+    size_t updated = 0;
+    uint32_t coveredEnd = 0;
+    for (uint32_t position : dirtyPositions)
+    {
+        if (position < coveredEnd)
+            continue;
+        coveredEnd = position + subtreeSize[position];
+        dirtyRanges.push_back({position, coveredEnd});
+        updated += coveredEnd - position;
+    }
+
+    size_t grain = std::max<size_t>(1, dirtyRanges.size() * PROPAGATE_GRAIN / std::max<size_t>(updated, 1));
+    ParallelFor(0, dirtyRanges.size(), grain, [this](size_t rangeBegin, size_t rangeEnd)
+                {
+                    for (size_t r = rangeBegin; r < rangeEnd; r++)
+                    {
+                        for (uint32_t k = dirtyRanges[r].first; k < dirtyRanges[r].second; k++)
+                        {
+                            uint32_t id = order[k];
+                            Page &page = PageOf(id);
+                            uint32_t slot = id % PAGE_SIZE;
+                            uint32_t parent = page.parent[slot];
+                            if (parent == INVALID_ID)
+                                page.localToWorld[slot] = page.localMatrix[slot];
+                            else
+                                MultiplyMatrix(PageOf(parent).localToWorld[parent % PAGE_SIZE], page.localMatrix[slot],
+                                               page.localToWorld[slot]);
+                        }
+                    } });
+    return updated;
+}
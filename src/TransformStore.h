@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// 所有Transform的数据按SoA分页存放，Transform本身只保存一个下标
+// 分量都是相对父节点的；setter只写分量并置脏标记
+// UpdateDirty()每帧一次：按页、按脏位批量重算局部矩阵（SSE每次4个），
+// 再在拓扑序数组（父节点在前、每棵子树连续）中只重算脏节点所在的子树的世界矩阵；两步都用JobSystem分块并行
+// 读取localToWorld时如果自身或祖先仍是脏的（例如本帧刚修改），沿父链单独计算
+// 分配/释放和setter可以在任意线程调用（导入线程会设置模型的transform）；
+// SetParent、UpdateDirty和矩阵读取在主线程（Transform的复制只在涉及父节点时调用SetParent）
+class TransformStore
+{
+public:
+    static constexpr uint32_t PAGE_SIZE = 1024;
+    static constexpr uint32_t MAX_PAGES = 1024; // 最多约100万个transform
+    static constexpr uint32_t INVALID_ID = ~0u;
+
+    // 场景对象可能在静态析构阶段才释放，store不随静态对象析构
+    static TransformStore &Instance()
+    {
+        static TransformStore *instance = new TransformStore();
+        return *instance;
+    }
+    TransformStore(const TransformStore &) = delete;
+    TransformStore &operator=(const TransformStore &) = delete;
+
+    // 新项为单位变换，并标记为脏
+    uint32_t Allocate();
+    void Free(uint32_t id);
+
+    glm::vec3 GetPosition(uint32_t id) const;
+    void SetPosition(uint32_t id, const glm::vec3 &position);
+    glm::quat GetRotation(uint32_t id) const;
+    glm::vec3 GetEulerAngles(uint32_t id) const;
+    // eulerAngles只用于读回，单位为度
+    void SetRotation(uint32_t id, const glm::quat &rotation, const glm::vec3 &eulerAngles);
+    glm::vec3 GetScale(uint32_t id) const;
+    void SetScale(uint32_t id, const glm::vec3 &scale);
+
+    // parent为INVALID_ID时成为根节点；保持局部分量不变，世界矩阵随之改变
+    void SetParent(uint32_t id, uint32_t parent);
+    uint32_t GetParent(uint32_t id) const { return PageOf(id).parent[id % PAGE_SIZE]; }
+
+    // trans * rotate * scale
+    glm::mat4 GetLocalMatrix(uint32_t id);
+    // 父节点的localToWorld * 局部矩阵
+    glm::mat4 GetLocalToWorld(uint32_t id);
+
+    // 重算所有脏项及其子树，返回重算的世界矩阵个数
+    size_t UpdateDirty();
+    size_t Count() const { return liveCount.load(std::memory_order_relaxed); }
+
+private:
+    TransformStore() = default;
+
+    struct Page
+    {
+        alignas(16) float positionX[PAGE_SIZE];
+        alignas(16) float positionY[PAGE_SIZE];
+        alignas(16) float positionZ[PAGE_SIZE];
+        alignas(16) float rotationX[PAGE_SIZE];
+        alignas(16) float rotationY[PAGE_SIZE];
+        alignas(16) float rotationZ[PAGE_SIZE];
+        alignas(16) float rotationW[PAGE_SIZE];
+        alignas(16) float scaleX[PAGE_SIZE];
+        alignas(16) float scaleY[PAGE_SIZE];
+        alignas(16) float scaleZ[PAGE_SIZE];
+        glm::vec3 eulerAngles[PAGE_SIZE];
+        glm::mat4 localMatrix[PAGE_SIZE];
+        glm::mat4 localToWorld[PAGE_SIZE];
+        // 层级：子节点用兄弟链表串起来，均为id
+        uint32_t parent[PAGE_SIZE];
+        uint32_t firstChild[PAGE_SIZE];
+        uint32_t prevSibling[PAGE_SIZE];
+        uint32_t nextSibling[PAGE_SIZE];
+        uint32_t orderIndex[PAGE_SIZE]; // 在order中的位置
+        bool alive[PAGE_SIZE];
+        // UpdateDirty中本页脏项在order中的位置
+        uint32_t dirtyCount;
+        uint32_t dirtyOrder[PAGE_SIZE];
+        // 每位对应一项，表示局部分量或父节点改过
+        std::atomic<uint64_t> dirty[PAGE_SIZE / 64];
+    };
+
+    Page &PageOf(uint32_t id) const { return *pages[id / PAGE_SIZE]; }
+    static void MarkDirty(Page &page, uint32_t slot)
+    {
+        page.dirty[slot / 64].fetch_or(uint64_t(1) << (slot % 64), std::memory_order_release);
+    }
+    bool IsDirty(uint32_t id) const
+    {
+        uint32_t slot = id % PAGE_SIZE;
+        return PageOf(id).dirty[slot / 64].load(std::memory_order_acquire) & (uint64_t(1) << (slot % 64));
+    }
+    // 计算局部矩阵，写入localMatrix
+    static void Compose(Page &page, uint32_t slot);
+    // slots为同一页中的4项
+    static void Compose4(Page &page, const uint32_t *slots);
+    // 从父节点链表中摘下，需持有mutex
+    void Unlink(uint32_t id);
+    // 从所有根节点深度优先重建order/subtreeSize，需持有mutex
+    void RebuildOrder();
+
+    // 页表长度固定，已分配的页地址不变，其他线程访问时不需要加锁
+    std::array<std::unique_ptr<Page>, MAX_PAGES> pages;
+    std::atomic<uint32_t> pageCount{0};
+    std::atomic<size_t> liveCount{0};
+    std::vector<uint32_t> freeIds;
+    // 拓扑序：父节点在子节点之前，order[i]的子树为order[i, i + subtreeSize[i])
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> subtreeSize;
+    bool orderDirty = false;
+    // UpdateDirty的临时数组
+    std::vector<uint32_t> dirtyPositions;
+    std::vector<std::pair<uint32_t, uint32_t>> dirtyRanges;
+    std::mutex mutex;
+};
@@ -0,0 +1,63 @@
+#include "VertexFormat.h"
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+#include "Parallel.h"
+
+static constexpr size_t PACK_GRAIN = 1 << 16;
+
+glm::vec3 PackedPositionScale(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    glm::vec3 extent = boundsMax - boundsMin;
+    // 扁平的轴（例如平面）避免除零
+    return glm::vec3(extent.x > 0.0f ? extent.x : 1.0f,
+                     extent.y > 0.0f ? extent.y : 1.0f,
+                     extent.z > 0.0f ? extent.z : 1.0f);
+}
+
+static int16_t ToSnorm16(float v)
+{
+    return (int16_t)std::lround(glm::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+static void OctEncode(glm::vec3 n, int16_t out[2])
+{
+    float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 < 1e-20f)
+    {
+        out[0] = out[1] = 0;
+        return;
+    }
+    n /= l1;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e = glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    out[0] = ToSnorm16(e.x);
+    out[1] = ToSnorm16(e.y);
+}
+
+void PackVertices(const float *vertices, int count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, PackedVertex *dst)
+{
+    glm::vec3 invScale = 1.0f / PackedPositionScale(boundsMin, boundsMax);
+    ParallelFor(0, count, PACK_GRAIN, [=](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const float *v = vertices + i * 8;
+                        PackedVertex &p = dst[i];
+
+                        glm::vec3 t = glm::clamp((glm::vec3(v[0], v[1], v[2]) - boundsMin) * invScale, 0.0f, 1.0f);
+                        p.position[0] = (uint16_t)std::lround(t.x * 65535.0f);
+                        p.position[1] = (uint16_t)std::lround(t.y * 65535.0f);
+                        p.position[2] = (uint16_t)std::lround(t.z * 65535.0f);
+                        p.position[3] = 0;
+
+                        OctEncode(glm::vec3(v[3], v[4], v[5]), p.normal);
+
+                        p.uv[0] = glm::packHalf1x16(v[6]);
+                        p.uv[1] = glm::packHalf1x16(v[7]);
+                    } });
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// GPU端顶点格式，CPU端始终保留8个float的交错格式（见Mesh.h）
+enum class VertexFormat
+{
+    Float32, // 32字节：pos(3f) nor(3f) uv(2f)
+    Packed16 // 16字节：pos(3 x unorm16，相对mesh包围盒) nor(八面体编码 2 x snorm16) uv(2 x half)
+};
+
+struct PackedVertex
+{
+    uint16_t position[4]; // 第4个分量仅用于对齐
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must be 16 bytes");
+
+inline int VertexStride(VertexFormat format)
+{
+    return format == VertexFormat::Packed16 ? (int)sizeof(PackedVertex) : 8 * (int)sizeof(float);
+}
+
+// 按包围盒量化顶点，着色器中 position = positionOffset + aPos * positionScale
+void PackVertices(const float *vertices, int count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, PackedVertex *dst);
+
+// 量化后的位置解码参数
+glm::vec3 PackedPositionScale(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
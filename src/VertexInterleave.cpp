@@ -0,0 +1,91 @@
+#include "VertexInterleave.h"
+#include "Parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define INTERLEAVE_SSE 1
+#endif
+
+// 每个并行块至少处理的顶点/面数
+static constexpr size_t INTERLEAVE_GRAIN = 1 << 16;
+
+template <bool HasNormals, bool HasUVs>
+static void InterleaveRange(const aiVector3D *positions, const aiVector3D *normals, const aiVector3D *uvs,
+                            float *dst, size_t begin, size_t end, size_t total)
+{
+    size_t i = begin;
+#ifdef INTERLEAVE_SSE
+    // 每次按16字节读取aiVector3D，会多读4字节，所以最后一个顶点留给标量路径
+    size_t simdEnd = std::min(end, total - 1);
+    for (; i < simdEnd; i++)
+    {
+        __m128 p = _mm_loadu_ps(&positions[i].x);
+        __m128 n = HasNormals ? _mm_loadu_ps(&normals[i].x) : _mm_setzero_ps();
+        __m128 t = HasUVs ? _mm_castpd_ps(_mm_load_sd((const double *)&uvs[i].x)) : _mm_setzero_ps();
+
+        // [px py pz nx] [ny nz u v]
+        __m128 pzNx = _mm_shuffle_ps(p, n, _MM_SHUFFLE(0, 0, 2, 2));
+        __m128 lo = _mm_shuffle_ps(p, pzNx, _MM_SHUFFLE(2, 0, 1, 0));
+        __m128 hi = _mm_shuffle_ps(n, t, _MM_SHUFFLE(1, 0, 2, 1));
+        _mm_storeu_ps(dst + i * 8 + 0, lo);
+        _mm_storeu_ps(dst + i * 8 + 4, hi);
+    }
+#endif
+    for (; i < end; i++)
+    {
+        float *v = dst + i * 8;
+        v[0] = positions[i].x;
+        v[1] = positions[i].y;
+        v[2] = positions[i].z;
+        v[3] = HasNormals ? normals[i].x : 0.0f;
+        v[4] = HasNormals ? normals[i].y : 0.0f;
+        v[5] = HasNormals ? normals[i].z : 0.0f;
+        v[6] = HasUVs ? uvs[i].x : 0.0f;
+        v[7] = HasUVs ? uvs[i].y : 0.0f;
+    }
+}
+
+void InterleaveVertices(const aiMesh *mesh, float *dst)
+{
+    const aiVector3D *positions = mesh->mVertices;
+    const aiVector3D *normals = mesh->mNormals;
+    const aiVector3D *uvs = mesh->mTextureCoords[0];
+    size_t total = mesh->mNumVertices;
+
+    // 属性是否存在只判断一次
+    auto range = &InterleaveRange<false, false>;
+    if (normals && uvs)
+        range = &InterleaveRange<true, true>;
+    else if (normals)
+        range = &InterleaveRange<true, false>;
+    else if (uvs)
+        range = &InterleaveRange<false, true>;
+
+    ParallelFor(0, total, INTERLEAVE_GRAIN, [=](size_t begin, size_t end)
+                { range(positions, normals, uvs, dst, begin, end, total); });
+}
+
+void CopyFaceIndices(const aiMesh *mesh, unsigned int *dst)
+{
+    const aiFace *faces = mesh->mFaces;
+    ParallelFor(0, mesh->mNumFaces, INTERLEAVE_GRAIN, [=](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const aiFace &face = faces[i];
+                        unsigned int *tri = dst + i * 3;
+                        if (face.mNumIndices == 3)
+                        {
+                            tri[0] = face.mIndices[0];
+                            tri[1] = face.mIndices[1];
+                            tri[2] = face.mIndices[2];
+                        }
+                        else
+                        {
+                            unsigned int last = face.mNumIndices > 0 ? face.mIndices[face.mNumIndices - 1] : 0;
+                            tri[0] = face.mNumIndices > 0 ? face.mIndices[0] : 0;
+                            tri[1] = face.mNumIndices > 1 ? face.mIndices[1] : last;
+                            tri[2] = last;
+                        }
+                    } });
+}
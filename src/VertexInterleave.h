@@ -0,0 +1,10 @@
+#pragma once
+#include <assimp/mesh.h>
+
+// 把aiMesh的位置/法线/UV交错写入dst（每个顶点8个float，布局见Mesh.h）
+// 缺失的法线和UV填0，大mesh按顶点区间并行处理
+void InterleaveVertices(const aiMesh *mesh, float *dst);
+
+// 把三角面索引写入dst（mNumFaces * 3）
+// 三角化后仍可能残留点/线图元，这类面用退化三角形填充
+void CopyFaceIndices(const aiMesh *mesh, unsigned int *dst);